@@ -1,67 +1,207 @@
 #ifndef AGENT_HPP
 #define AGENT_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <thread>
 #include <vector>
 
+#include "Core.hpp"
 #include "Data.hpp"
-#include "Utils.hpp"
+#include "OpeningBook.hpp"
+#include "PlayoutBatch.hpp"
+#include "Telemetry.hpp"
+#include "TranspositionTable.hpp"
 
-class Game;
 class Tree;
+class TreePool;
 
-class CompareTree
+class Tree
 {
-	public:
+	public: 
+		
+		Tree();
+		void expand(const Data&, TreePool&, RandomEngine&);
+		void allocateArrays(TreePool&);
+		Tree * copy(Tree *, TreePool&) const;
+		Cell move() const;
+		Tree * findChild(Cell) const;
+	
+		Tree * father;
+		uint64_t hash;
+		unsigned short index;
+		Player player;
+		std::atomic<unsigned int> nbSimulations;
+		// Visits the table seeded the node with: they weigh in its UCT value, but the
+		// choice of the move only counts the playouts run in this tree.
+		unsigned int priorVisits;
+		bool expanded;
+		unsigned short nbChilds;
+		unsigned short nbMoves;
+		// Statistics of the children, as parallel arrays of nbMoves entries so that
+		// selection scans them without touching the child nodes. The first nbChilds
+		// moves have a node, the others are untried, in random order. The rave
+		// arrays count the playouts below this node in which the move was played
+		// later by the same player (all moves as first), untried moves included.
+		Cell * moves;
+		std::atomic<unsigned int> * wins;
+		std::atomic<unsigned int> * visits;
+		std::atomic<unsigned int> * raveWins;
+		std::atomic<unsigned int> * raveVisits;
+		Tree ** childs;
+		SpinLock protect;
+};
 
-		CompareTree(double);
-		bool operator()(Tree * left, Tree * right) const;
+// Arena for the nodes and child arrays of one search tree. Memory never moves
+// once handed out, and the whole arena is dropped at once by reset().
+class TreePool
+{
+	public:
 	
+		TreePool();
+		TreePool(const TreePool&) = delete;
+		TreePool& operator=(const TreePool&) = delete;
+		
+		Tree * createNode();
+		template<typename T>
+		T * allocate(unsigned int);
+		void * allocateBytes(std::size_t, std::size_t);
+		void reset();
+		unsigned int size() const;
+		
+		~TreePool();
+		
 	private:
 	
-		double cUCT;
+		static const std::size_t chunkSize = 1 << 20;
+	
+		std::vector<std::unique_ptr<char[]>> chunks;
+		unsigned int nbChunks;
+		std::size_t used;
+		std::atomic<unsigned int> nbNodes;
+		SpinLock protect;
 };
 
-class Tree
+template<typename T>
+T * TreePool::allocate(unsigned int number)
 {
-	public: 
-		
-		Tree(Tree *, const Data&, sf::Vector2u, Player);
-		double UCT(double) const;
-		void clear(Tree *);
-		Tree * findChild(sf::Vector2u) const;
-		~Tree();
+	T * block = static_cast<T*>(allocateBytes(number * sizeof(T), alignof(T)));
+	for (unsigned int element = 0; element < number; ++element)
+		new (&block[element]) T();
+	return block;
+}
+
+// A zero field means no limit on that resource, but with every field at zero the
+// search runs a single playout. With earlyStop, the search also ends once the
+// remaining budget cannot change the most visited move.
+struct SearchLimits
+{
+	SearchLimits(Seconds _time = Seconds(2.5), unsigned int _playouts = 0, 
+	             unsigned int _nodes = 0, bool _earlyStop = false) :
+	                   time(_time), playouts(_playouts), nodes(_nodes), earlyStop(_earlyStop)
+	{}
 	
-		Tree * father;
-		sf::Vector2u move;
-		Player player;
-		std::vector<Tree*> childs;
-		std::vector<sf::Vector2u> noMoves;
-		unsigned int nbWins;
-		unsigned int nbSimulations;
-		
-		static unsigned int count;
+	Seconds time;
+	unsigned int playouts;
+	unsigned int nodes;
+	bool earlyStop;
 };
 
 class Agent
 {
 	public:
 	
-		Agent(Game *, Data *, unsigned int);
+		Agent(Data *, unsigned int, Player, SearchMode = SearchMode::Sequential, unsigned int = 1);
 		
-		void UCT();
-		void pruning(sf::Vector2u, Player);
+		Cell UCT();
+		void ponder();
+		void stopPondering();
+		// Ends the search under way from another thread: UCT() returns at once with
+		// the best move found so far.
+		void stop();
+		// Drops a stop() that came once the search was over, so that the next one runs.
+		void resume();
+		void pruning(Cell);
+		void setLimits(SearchLimits);
+		void setPondering(bool);
+		void setSeed(unsigned int);
+		// Memory cap of the transposition table in megabytes, 0 to search without one.
+		void setTableSize(unsigned int);
+		// Equivalence parameter k of the MC-RAVE schedule, 0 for plain UCT.
+		void setRave(unsigned int);
+		// Playouts run from each leaf reached, up to PlayoutBatch::maxPlayouts.
+		void setBatch(unsigned int);
+		// One JSON line per move searched, see MoveReport. Nothing is written with nullptr.
+		void setTelemetry(std::ostream *);
+		// Positions found in the book are played without a search. Nothing is looked up with nullptr.
+		void setBook(const OpeningBook *);
+		unsigned int playouts() const;
 		
 		~Agent();
 		
 	private:
+	
+		void prepareRoots(Player);
+		void launch(std::vector<std::thread>&, SteadyClock::time_point);
+		void search(Tree *, TreePool&, unsigned int, SteadyClock::time_point);
+		bool finished(SteadyClock::time_point) const;
+		bool decided(unsigned int, Seconds) const;
+		unsigned int nbNodes() const;
+		void rootVisits(std::vector<unsigned int>&) const;
+		double winRate(Cell) const;
+		void report(Cell, Seconds);
+		Cell bestMove() const;
 		
-		Game * game;
 		unsigned int size;
 		Data * data;
-		Tree * tree;
+		Player self;
+		SearchMode mode;
+		unsigned int nbThreads;
+		unsigned int seed;
+		float raveEquivalence;
+		unsigned int batchSize;
+		SearchLimits limits;
+		std::atomic<unsigned int> nbPlayouts;
+		bool ponderingEnabled;
+		bool pondering;
+		std::atomic<bool> stopSearch;
+		std::vector<std::thread> ponderers;
+		std::ostream * telemetry;
+		const OpeningBook * book;
+		unsigned int nbReports;
+		unsigned int nodesFreed;
+		SearchStats stats;
+		SpinLock protectStats;
+		std::vector<Tree*> trees;
+		std::vector<std::unique_ptr<TreePool>> pools;
+		std::unique_ptr<TreePool> spare;
+		std::unique_ptr<TranspositionTable> table;
+};
+
+// What one search thread carries down and up the tree.
+struct Worker
+{
+	Worker(TreePool& _pool, TranspositionTable * _table, float _raveEquivalence, unsigned int seed, unsigned int _batchSize = 1) :
+	                   pool(_pool), table(_table), raveEquivalence(_raveEquivalence), batchSize(_batchSize), generator(seed)
+	{}
+	
+	TreePool& pool;
+	TranspositionTable * table;
+	float raveEquivalence;
+	unsigned int batchSize;
+	RandomEngine generator;
+	SearchStats stats;
+	PlayoutBatch batch;
 };
 
-Tree * selection(Tree *, Data&, Player);
-void reachBack(Tree *, Player);
+Tree * selection(Tree *, Data&, Player, Worker&);
+void reachBack(Tree *, Player, Worker&, const Data&);
+void reachBack(Tree *, Worker&);
+void updateRave(Tree *, const Data&, Player);
+void updateRave(Tree *, const PlayoutBatch&);
 
-#endif
\ No newline at end of file
+#endif
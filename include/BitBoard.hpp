@@ -0,0 +1,97 @@
+#ifndef BIT_BOARD_HPP
+#define BIT_BOARD_HPP
+
+#include <cstdint>
+
+template<unsigned int NbBits>
+class BitBoard
+{
+	public:
+
+		static const unsigned int nbWords = (NbBits + 63) / 64;
+
+		BitBoard()
+		{
+			clear();
+		}
+
+		void clear()
+		{
+			for (unsigned int word = 0; word < nbWords; ++word)
+				words[word] = 0;
+		}
+
+		void set(unsigned int bit)
+		{
+			words[bit >> 6] |= uint64_t(1) << (bit & 63);
+		}
+
+		void reset(unsigned int bit)
+		{
+			words[bit >> 6] &= ~(uint64_t(1) << (bit & 63));
+		}
+
+		uint64_t word(unsigned int index) const
+		{
+			return words[index];
+		}
+
+		bool test(unsigned int bit) const
+		{
+			return (words[bit >> 6] >> (bit & 63)) & 1;
+		}
+
+		unsigned int count() const
+		{
+			unsigned int result = 0;
+			for (unsigned int word = 0; word < nbWords; ++word)
+				result += __builtin_popcountll(words[word]);
+			return result;
+		}
+
+		template<typename Function>
+		void forEach(Function function) const
+		{
+			for (unsigned int word = 0; word < nbWords; ++word)
+			{
+				uint64_t value = words[word];
+				while (value != 0)
+				{
+					function(word * 64 + __builtin_ctzll(value));
+					value &= value - 1;
+				}
+			}
+		}
+
+		BitBoard& operator|=(const BitBoard& other)
+		{
+			for (unsigned int word = 0; word < nbWords; ++word)
+				words[word] |= other.words[word];
+			return *this;
+		}
+
+		BitBoard& operator&=(const BitBoard& other)
+		{
+			for (unsigned int word = 0; word < nbWords; ++word)
+				words[word] &= other.words[word];
+			return *this;
+		}
+
+	private:
+
+		uint64_t words[nbWords];
+};
+
+template<unsigned int NbBits>
+inline BitBoard<NbBits> operator|(BitBoard<NbBits> left, const BitBoard<NbBits>& right)
+{
+	return left |= right;
+}
+
+template<unsigned int NbBits>
+inline BitBoard<NbBits> operator&(BitBoard<NbBits> left, const BitBoard<NbBits>& right)
+{
+	return left &= right;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef CORE_HPP
+#define CORE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "Random.hpp"
+
+// Types of the engine, shared with its clients. Nothing in the engine depends on
+// SFML: the graphical interface converts cells with Utils.hpp.
+
+enum class Player
+{
+	Empty,
+	AI,
+	Human
+};
+
+enum class SearchMode
+{
+	Sequential,
+	RootParallel,
+	TreeParallel
+};
+
+typedef std::chrono::steady_clock SteadyClock;
+typedef std::chrono::duration<double> Seconds;
+
+// A cell of the board, both coordinates packed in 16 bits.
+struct Cell
+{
+	Cell() : x(0), y(0)
+	{}
+	Cell(unsigned int _x, unsigned int _y) : x(_x), y(_y)
+	{}
+	
+	bool operator==(const Cell& other) const
+	{
+		return x == other.x && y == other.y;
+	}
+	
+	bool operator!=(const Cell& other) const
+	{
+		return !(*this == other);
+	}
+	
+	uint8_t x;
+	uint8_t y;
+};
+
+class SpinLock
+{
+	public:
+	
+		SpinLock() : locked(false)
+		{}
+		
+		void lock()
+		{
+			while (locked.exchange(true, std::memory_order_acquire))
+			{}
+		}
+		
+		void unlock()
+		{
+			locked.store(false, std::memory_order_release);
+		}
+		
+	private:
+	
+		std::atomic<bool> locked;
+};
+
+inline Player nextPlayer(Player player)
+{
+	if (player == Player::Human)
+		return Player::AI;
+	if (player == Player::AI)
+		return Player::Human;
+	return Player::Empty;
+}
+
+#endif
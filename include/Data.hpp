@@ -1,40 +1,105 @@
 #ifndef DATA_HPP
 #define DATA_HPP
 
-#include <set>
+#include <cstdint>
 #include <vector>
 
-#include "Utils.hpp"
+#include "BitBoard.hpp"
+#include "Core.hpp"
+#include "Geometry.hpp"
+#include "Telemetry.hpp"
+
+// The moves of one playout in the order they were played, alternating from the
+// player given to Data::MonteCarlo(). Sized for the largest board, so recording a
+// playout never allocates.
+struct Playout
+{
+	Playout() : nbMoves(0)
+	{}
+	
+	unsigned int nbMoves;
+	Cell moves[Geometry::maxSize * Geometry::maxSize];
+};
 
 class Data
 {
 	public:
 	
+		static const unsigned int maxSize = Geometry::maxSize;
+		
+		// One bit per Geometry node. Each player's two sides are set in its own plane, so
+		// a stone on the edge merges with its side like with any friendly neighbour.
+		typedef BitBoard<Geometry::NbNodes> Plane;
+	
 		Data(unsigned int);
 		
 		Player winner() const;
+		// Zobrist hash of the stones, updated by every move.
+		uint64_t hash() const;
 		
 		Player operator()(unsigned int, unsigned int) const;
-		Player operator()(sf::Vector2u) const;
+		Player operator()(Cell) const;
 		
-		Player MonteCarlo(sf::Vector2u, Player);
-		void makeMove(sf::Vector2u position, Player player);
-		std::vector<sf::Vector2u> moves() const;
-		bool isEmpty(sf::Vector2u) const;
+		// Fills the board at random and returns its winner. The board then only holds
+		// the stones and the winner: no move may follow, and takeBack() cannot remove them.
+		Player MonteCarlo(Cell, Player, RandomEngine&, SearchStats * = nullptr, Playout * = nullptr);
+		// The same fill, leaving the winner to be found from the stones.
+		void fillAtRandom(Cell, Player, RandomEngine&, SearchStats * = nullptr, Playout * = nullptr);
+		// The winner of a full board, such as fillAtRandom() leaves, by one flood.
+		Player fullBoardWinner() const;
+		void makeMove(Cell position, Player player);
+		// Moves played since the board was created.
+		unsigned int nbPlayed() const;
+		// Takes back the last moves until the given number is left, groups, hash and
+		// winner included, so that a search can walk down and up the same board.
+		void takeBack(unsigned int);
+		std::vector<Cell> moves() const;
+		void moves(Cell*) const;
+		unsigned int nbMoves() const;
+		bool isEmpty(Cell) const;
+		// On the board, empty, and the game not won yet.
+		bool isLegal(Cell) const;
+		const Plane& stones(Player) const;
+		const Geometry& layout() const;
 		
 	private:
 	
-		Player& operator()(unsigned int, unsigned int);
-		Player& operator()(sf::Vector2u);
-		void disconnect(sf::Vector2u, Player, sf::Vector2u&) const;
-		bool diamondPattern(sf::Vector2i, sf::Vector2i, sf::Vector2i, Player) const;
-		bool correct(sf::Vector2i) const;
+		// What takeBack() needs to remove the stone of a move: the number of groups
+		// it joined, and whether it won the game.
+		struct Move
+		{
+			uint16_t cell;
+			uint8_t nbLinks;
+			bool won;
+		};
 	
-		std::vector<sf::Vector2u> neighboursCoor(sf::Vector2u) const;
+		void play(unsigned int, Player);
+		void fill(unsigned int, Player);
+		void undo(const Move&);
+		bool respond(unsigned int, Player, RandomEngine&, unsigned int&) const;
+		unsigned int find(unsigned int) const;
+		bool merge(unsigned int, unsigned int);
 	
+		const Geometry * geometry;
 		unsigned int size;
-		std::vector<Player> board;
-		std::set<sf::Vector2u, CompareVector2<unsigned>> movesList;
+		Plane aiStones;
+		Plane humanStones;
+		Plane emptyCells;
+		// Groups of stones as a union-find without path compression, so that a merge
+		// is undone by making the linked root a root again. The smaller group goes
+		// under the larger one, which keeps the trees logarithmic.
+		uint16_t parent[Geometry::NbNodes];
+		// Stones of each group, up to date on the roots only.
+		uint16_t groupSize[Geometry::NbNodes];
+		// The moves in the order they were played, and the roots they linked.
+		Move played[Geometry::Top];
+		uint16_t links[Geometry::NbNodes];
+		unsigned int nbMovesPlayed;
+		unsigned int nbLinks;
+		// Pattern code of every cell, see Patterns. The sides have one too, never read.
+		uint16_t codes[Geometry::NbNodes];
+		uint64_t hashKey;
+		Player winnerPlayer;
 };
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef EVENT_QUEUE_HPP
+#define EVENT_QUEUE_HPP
+
+#include <atomic>
+
+// Ring of events between exactly one thread that pushes and one that pops,
+// without locks: each side only writes its own index, and publishes it after the
+// slot it covers. The indices sit on separate cache lines so that the two threads
+// do not fight over one. Holds Capacity - 1 events at most.
+template<typename T, unsigned int Capacity>
+class EventQueue
+{
+	public:
+
+		EventQueue() : head(0), tail(0)
+		{}
+
+		EventQueue(const EventQueue&) = delete;
+		EventQueue& operator=(const EventQueue&) = delete;
+
+		// False, and the event dropped, when the queue is full.
+		bool push(const T& event)
+		{
+			unsigned int back = tail.load(std::memory_order_relaxed);
+			unsigned int next = (back + 1) % Capacity;
+			if (next == head.load(std::memory_order_acquire))
+				return false;
+			events[back] = event;
+			tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		// False when the queue is empty.
+		bool pop(T& event)
+		{
+			unsigned int front = head.load(std::memory_order_relaxed);
+			if (front == tail.load(std::memory_order_acquire))
+				return false;
+			event = events[front];
+			head.store((front + 1) % Capacity, std::memory_order_release);
+			return true;
+		}
+
+	private:
+
+		alignas(64) std::atomic<unsigned int> head;
+		alignas(64) std::atomic<unsigned int> tail;
+		alignas(64) T events[Capacity];
+};
+
+#endif
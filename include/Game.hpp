@@ -1,23 +1,26 @@
 #ifndef GAME_HPP
 #define GAME_HPP
 
-#include <queue>
-
-#include <SFML/System.hpp>
+#include <fstream>
+#include <string>
+#include <thread>
 
 #include "Data.hpp"
+#include "EventQueue.hpp"
+#include "OpeningBook.hpp"
 #include "Utils.hpp"
 
 class UserView;
 class GameEvent;
 class Data;
 class Agent;
+struct SearchLimits;
 
 class Game
 {
 	public:
 	
-		Game(unsigned int, Player);
+		Game(unsigned int, Player, SearchMode, unsigned int, const SearchLimits&, bool, unsigned int, unsigned int, const std::string&);
 		Game(const Game&) = delete;
 		Game& operator=(const Game&) = delete;
 		
@@ -28,7 +31,10 @@ class Game
 	
 	private:
 	
-		void processEvent();
+		void think();
+		void cancel();
+		bool processEvents();
+		void play(const GameEvent&);
 	
 		unsigned int size;
 		Data data;
@@ -36,8 +42,14 @@ class Game
 		bool finish;
 		UserView * view;
 		Agent * agent;
-		std::queue<GameEvent> events;
-		sf::Mutex protectEvents;
+		OpeningBook book;
+		std::ofstream log;
+		// The window pushes the input, the searcher the move of the agent, and the
+		// main loop pops both.
+		EventQueue<GameEvent, 64> events;
+		EventQueue<GameEvent, 2> answers;
+		std::thread searcher;
+		bool searching;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef GEOMETRY_HPP
+#define GEOMETRY_HPP
+
+#include <cstdint>
+
+#include "Core.hpp"
+
+// Largest board the engine is compiled for. Build with -DHEX_MAX_SIZE=11 (or 13)
+// to shrink every position to the smallest number of words for that size.
+#ifndef HEX_MAX_SIZE
+#define HEX_MAX_SIZE 19
+#endif
+
+// Precomputed neighbourhood of every cell for one board size, shared by all the
+// positions of that size. Cells are numbered y*(size+1) + x: each row is padded
+// with one always empty column, so that the flood of PlayoutBatch, which shifts
+// the words of a plane by one cell, never wraps a stone onto the opposite side of
+// the board. After the cells come one virtual node per side: a neighbour off the
+// board is the side it lies beyond.
+class Geometry
+{
+	public:
+	
+		static const unsigned int maxSize = HEX_MAX_SIZE;
+		
+		enum Side
+		{
+			Top = maxSize * (maxSize + 1),
+			Bottom,
+			Left,
+			Right,
+			NbNodes
+		};
+		
+		static const Geometry& get(unsigned int);
+		
+		// The neighbour in the opposite direction sees the cell in this one.
+		static unsigned int opposite(unsigned int);
+		
+		unsigned int index(unsigned int, unsigned int) const;
+		Cell coordinates(unsigned int) const;
+	
+		unsigned int size;
+		unsigned int stride;
+		// In turning order: two successive neighbours are neighbours too.
+		uint16_t neighbours[Top][6];
+		// Pattern code of every cell on the empty board, where only the sides count.
+		uint16_t sides[Top];
+		
+	private:
+	
+		Geometry(unsigned int);
+		unsigned int node(int, int) const;
+};
+
+inline unsigned int Geometry::opposite(unsigned int direction)
+{
+	return (direction + 3) % 6;
+}
+
+inline unsigned int Geometry::index(unsigned int x, unsigned int y) const
+{
+	return y*stride + x;
+}
+
+inline Cell Geometry::coordinates(unsigned int cell) const
+{
+	return Cell(cell % stride, cell / stride);
+}
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef OPENING_BOOK_HPP
+#define OPENING_BOOK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Core.hpp"
+
+// Moves searched in advance for the first positions of the game, read straight
+// from a memory-mapped file. The file holds a header, then an index of
+// 2^indexBits + 1 offsets, then the entries sorted by hash, 8-byte aligned. The
+// entries whose hash starts with the bits b lie between index[b] and
+// index[b + 1], a handful at most, so a lookup costs one bucket whatever the
+// size of the book. The hash is
+// Data::hash(), and one file can hold several board sizes. The tools/Book.cpp
+// builder writes it; it is read in the byte order of the machine that wrote it.
+class OpeningBook
+{
+	public:
+
+		struct Entry
+		{
+			uint64_t hash;
+			uint8_t size;
+			uint8_t player;
+			uint8_t x;
+			uint8_t y;
+			// Playouts behind the move.
+			uint32_t playouts;
+		};
+
+		OpeningBook();
+		OpeningBook(const OpeningBook&) = delete;
+		OpeningBook& operator=(const OpeningBook&) = delete;
+
+		// Maps the file, dropping the book opened before. False, and the book left
+		// empty, when the file is missing or is not a book.
+		bool open(const std::string&);
+		// The move of the book for the position and the player to move.
+		bool find(uint64_t, unsigned int, Player, Cell&) const;
+		unsigned int size() const;
+
+		// Sorts the entries and writes them with their index.
+		static bool write(const std::string&, std::vector<Entry>);
+
+		~OpeningBook();
+
+	private:
+
+		struct Header
+		{
+			char magic[8];
+			uint32_t version;
+			uint32_t indexBits;
+			uint32_t nbEntries;
+			uint32_t unused;
+		};
+
+		void close();
+		bool map(const std::string&);
+		static unsigned int bucket(uint64_t, unsigned int);
+		static std::size_t entriesOffset(unsigned int);
+
+		const char * mapping;
+		std::size_t length;
+#ifdef _WIN32
+		void * file;
+		void * fileMapping;
+#endif
+		const Header * header;
+		const uint32_t * index;
+		const Entry * entries;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef PATTERNS_HPP
+#define PATTERNS_HPP
+
+#include <cstdint>
+
+#include "Core.hpp"
+
+// Weights of the local patterns of the playout policy. The pattern of a cell is
+// the code of its six neighbours, two bits each in the order of
+// Geometry::neighbours, which turn around the cell: 0 empty, 1 a stone or a side
+// of Player::AI, 2 a stone or a side of Player::Human. Data keeps the code of
+// every cell up to date as stones are played, and answers each playout move
+// with one of its empty neighbours, drawn in proportion to their weights.
+class Patterns
+{
+	public:
+
+		static const unsigned int nbCodes = 1 << 12;
+
+		static const Patterns& get();
+		static unsigned int stone(Player);
+
+		// Weight, for the player to move, of the cell with the given code when the
+		// move just played is its neighbour in the given direction. Zero when no
+		// pattern matches.
+		unsigned int weight(unsigned int, unsigned int, Player) const;
+
+	private:
+
+		Patterns();
+
+		// One table per player to move, Player::AI first.
+		uint8_t weights[2][nbCodes];
+};
+
+inline unsigned int Patterns::stone(Player player)
+{
+	return player == Player::AI ? 1 : 2;
+}
+
+// The tables have the move just played in the first slot, so the code is turned.
+inline unsigned int Patterns::weight(unsigned int code, unsigned int direction, Player toMove) const
+{
+	code = ((code >> 2*direction) | (code << (12 - 2*direction))) & (nbCodes - 1);
+	return weights[toMove == Player::AI ? 0 : 1][code];
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef PLAYOUT_BATCH_HPP
+#define PLAYOUT_BATCH_HPP
+
+#include <cstdint>
+
+#include "Core.hpp"
+#include "Data.hpp"
+#include "Geometry.hpp"
+#include "Telemetry.hpp"
+
+// Several playouts from the same leaf, whose final boards are kept side by side
+// as bit planes: word w of board b is at stones[w][b]. The flood fill that finds
+// the winners then runs the same instructions on lanes boards at once, which the
+// compiler turns into vector code (build with ARCH=-mavx2 for four boards per
+// instruction). The results are summed once per batch, so that the tree is
+// walked and its atomics touched once for all the playouts.
+class PlayoutBatch
+{
+	public:
+
+		static const unsigned int lanes = 4;
+		static const unsigned int maxPlayouts = 64;
+
+		PlayoutBatch();
+
+		// The given number of playouts, at most maxPlayouts, from a board without a
+		// winner, the same arguments as Data::MonteCarlo() otherwise.
+		void run(const Data&, Cell, Player, unsigned int, RandomEngine&, SearchStats * = nullptr);
+
+		unsigned int size() const;
+		unsigned int wins(Player) const;
+		// Boards on which the player holds the cell, and those of them it won.
+		unsigned int owned(Cell, Player) const;
+		unsigned int ownedWins(Cell, Player) const;
+
+	private:
+
+		static const unsigned int nbWords = Data::Plane::nbWords;
+		typedef uint64_t Planes[nbWords][lanes];
+
+		void prepare(const Geometry&);
+		void findWinners();
+		void count();
+
+		const Geometry * geometry;
+		unsigned int nbPlayouts;
+		unsigned int aiWins;
+		// Words of the planes that hold cells of the board.
+		unsigned int nbUsed;
+		uint64_t cells[nbWords];
+		uint64_t topRow[nbWords];
+		uint64_t bottomRow[nbWords];
+		// The Player::AI stones of every board, without its sides.
+		uint64_t stones[nbWords][maxPlayouts];
+		bool aiWon[maxPlayouts];
+		uint16_t aiOwned[Geometry::Top];
+		uint16_t aiOwnedWins[Geometry::Top];
+};
+
+inline unsigned int PlayoutBatch::size() const
+{
+	return nbPlayouts;
+}
+
+inline unsigned int PlayoutBatch::wins(Player player) const
+{
+	return player == Player::AI ? aiWins : nbPlayouts - aiWins;
+}
+
+// Every board of the batch is full: a cell that is not Player::AI's is the other's.
+inline unsigned int PlayoutBatch::owned(Cell cell, Player player) const
+{
+	unsigned int ai = aiOwned[geometry->index(cell.x, cell.y)];
+	return player == Player::AI ? ai : nbPlayouts - ai;
+}
+
+inline unsigned int PlayoutBatch::ownedWins(Cell cell, Player player) const
+{
+	unsigned int index = geometry->index(cell.x, cell.y);
+	if (player == Player::AI)
+		return aiOwnedWins[index];
+	return (nbPlayouts - aiWins) - (aiOwned[index] - aiOwnedWins[index]);
+}
+
+#endif
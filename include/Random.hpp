@@ -0,0 +1,85 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+// xoshiro256** generator: a few shifts and rotations per number and a 32 bytes
+// state, so every search thread owns one. The state is expanded from a single
+// seed with splitmix64, and the draws below do not depend on the standard
+// library, so a seed gives the same games on every platform.
+class RandomEngine
+{
+	public:
+
+		typedef uint64_t result_type;
+
+		explicit RandomEngine(uint64_t seed = 0)
+		{
+			this->seed(seed);
+		}
+
+		void seed(uint64_t value)
+		{
+			for (auto& word : state)
+			{
+				value += 0x9e3779b97f4a7c15ull;
+				uint64_t mixed = value;
+				mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+				mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+				word = mixed ^ (mixed >> 31);
+			}
+		}
+
+		static constexpr result_type min()
+		{
+			return 0;
+		}
+
+		static constexpr result_type max()
+		{
+			return UINT64_MAX;
+		}
+
+		result_type operator()()
+		{
+			uint64_t result = rotate(state[1] * 5, 7) * 9;
+			uint64_t shifted = state[1] << 17;
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= shifted;
+			state[3] = rotate(state[3], 45);
+			return result;
+		}
+
+		// Uniform in [0, bound), by multiplication instead of a division.
+		unsigned int below(unsigned int bound)
+		{
+			return (((*this)() >> 32) * bound) >> 32;
+		}
+
+		// Fisher-Yates, with the draws of below().
+		template<typename T>
+		void shuffle(T * first, unsigned int count)
+		{
+			for (unsigned int last = count; last > 1; --last)
+			{
+				unsigned int other = below(last);
+				T value = first[last - 1];
+				first[last - 1] = first[other];
+				first[other] = value;
+			}
+		}
+
+	private:
+
+		static uint64_t rotate(uint64_t value, unsigned int shift)
+		{
+			return (value << shift) | (value >> (64 - shift));
+		}
+
+		uint64_t state[4];
+};
+
+#endif
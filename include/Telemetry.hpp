@@ -0,0 +1,97 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Counters of one search. Each search thread fills its own copy with plain
+// increments and adds it to the agent's total when it stops. The phases are
+// only timed on one descent out of samplePeriod, and the totals are scaled up
+// from those samples, so the clock is read a few times per hundred playouts.
+struct SearchStats
+{
+	enum Phase
+	{
+		Selection,
+		Playout,
+		WinnerDetection,
+		Backpropagation,
+		NbPhases
+	};
+
+	static const unsigned int samplePeriod = 16;
+
+	SearchStats();
+
+	void clear();
+	SearchStats& operator+=(const SearchStats&);
+	// Which phases the next descent times: the winner detection is timed
+	// inside the playout, so it is sampled apart from the other phases to
+	// keep the extra clock reads out of the playout time.
+	void nextPlayout();
+	// Starts the clock of a timed descent, then charges the time since the last
+	// mark to a phase, for the given number of playouts. Both do nothing on the
+	// other descents.
+	uint64_t start() const;
+	void lap(Phase, uint64_t&, unsigned int = 1);
+	// Charges a short interval started at the given time, minus the cost of
+	// reading the clock, which would otherwise dominate it.
+	void charge(Phase, uint64_t);
+	double estimate(Phase) const;
+
+	static uint64_t now();
+	static uint64_t clockCost();
+
+	uint64_t playouts;
+	// Walks down the tree: one per playout, unless the playouts come in batches.
+	uint64_t descents;
+	uint64_t expansions;
+	uint64_t patternAnswers;
+	uint64_t depthSum;
+	unsigned int maxDepth;
+	bool timePhases;
+	bool timeWinner;
+	uint64_t samples[NbPhases];
+	uint64_t nanoseconds[NbPhases];
+};
+
+inline uint64_t SearchStats::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	       std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t SearchStats::start() const
+{
+	return timePhases ? now() : 0;
+}
+
+inline void SearchStats::lap(Phase phase, uint64_t& mark, unsigned int nbPlayouts)
+{
+	if (!timePhases)
+		return ;
+	uint64_t current = now();
+	nanoseconds[phase] += current - mark;
+	samples[phase] += nbPlayouts;
+	mark = current;
+}
+
+// Everything reported for one move of the agent, as one JSON object per line.
+// The phase times add up the time of every search thread.
+struct MoveReport
+{
+	unsigned int move;
+	const char * player;
+	unsigned int x;
+	unsigned int y;
+	double seconds;
+	double winRate;
+	unsigned int nodesAlive;
+	unsigned int nodesFreed;
+	SearchStats stats;
+};
+
+std::ostream& operator<<(std::ostream&, const MoveReport&);
+
+#endif
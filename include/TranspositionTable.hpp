@@ -0,0 +1,56 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Playout statistics per position, shared by every node of the search reaching
+// that position through a different move order. The table has a fixed number of
+// buckets of four entries, 64 bytes each, and never grows: a new position
+// takes the least useful entry of its bucket. Threads access it without locks,
+// so a racing replacement may lose or mix a few playouts, like any statistic.
+class TranspositionTable
+{
+	public:
+
+		struct Entry
+		{
+			Entry() : key(0), wins(0), visits(0)
+			{}
+
+			std::atomic<uint64_t> key;
+			std::atomic<unsigned int> wins;
+			std::atomic<unsigned int> visits;
+		};
+
+		// Largest power of two of buckets fitting in the given number of megabytes.
+		explicit TranspositionTable(unsigned int);
+
+		const Entry * find(uint64_t) const;
+		// Adds playouts, and the wins among them.
+		void update(uint64_t, unsigned int, unsigned int);
+		// Entries untouched since the last call are replaced first.
+		void newGeneration();
+		std::size_t size() const;
+
+	private:
+
+		static const unsigned int bucketSize = 4;
+		static const uint64_t generationMask = 0xff;
+
+		struct Bucket
+		{
+			Entry entries[bucketSize];
+		};
+
+		Bucket& bucket(uint64_t) const;
+		static bool matches(const Entry&, uint64_t);
+
+		std::unique_ptr<Bucket[]> buckets;
+		std::size_t nbBuckets;
+		uint64_t generation;
+};
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef UCT_KERNEL_HPP
+#define UCT_KERNEL_HPP
+
+#include <atomic>
+
+// Index of the child maximising (1-beta)*wins/visits + beta*raveWins/raveVisits
+// + cUCT * sqrt(logFather/visits), the first one on ties, where the MC-RAVE
+// schedule beta = sqrt(k / (3*visits + k)) fades the AMAF estimate as the child
+// gets real visits; k = raveEquivalence, 0 for plain UCT. Every visit count must
+// be positive. Uses AVX2 or SSE2 when the processor has them, plain C++ otherwise.
+unsigned int bestUCT(const std::atomic<unsigned int> * wins, const std::atomic<unsigned int> * visits, 
+                     const std::atomic<unsigned int> * raveWins, const std::atomic<unsigned int> * raveVisits, 
+                     unsigned int nbChilds, float cUCT, float logFather, float raveEquivalence);
+
+#endif
@@ -1,7 +1,7 @@
 #ifndef USER_VIEW_HPP
 #define USER_VIEW_HPP
 
-#include <vector>
+#include <atomic>
 
 #include <SFML/Graphics.hpp>
 
@@ -20,6 +20,9 @@ class UserView : public sf::Drawable, public sf::Transformable
 		void close();
 		bool collision(unsigned int, unsigned int, sf::Vector2u&) const;
 		virtual void draw(sf::RenderTarget&, sf::RenderStates) const;
+		// True once after each change of the view: the rendering thread only draws
+		// a new frame then.
+		bool hasChanged() const;
 		bool isOpen() const;
 		bool readUserInput();
 		void setColor(sf::Vector2u position, Player player);
@@ -29,28 +32,37 @@ class UserView : public sf::Drawable, public sf::Transformable
 	
 	private:
 	
-		sf::Sprite createStone(sf::Vector2f position) const;
-		sf::Sprite createStone(float, float) const;
+		void addStone(sf::Vector2f, sf::Color);
+		void addStone(float, float, sf::Color);
 		unsigned int index(unsigned int x, unsigned int y) const;
 		void initBackground();
 		void initHexagons();
+		void initBoard();
 		void initSide();
 	
 		sf::RenderWindow * window;
 		sf::Thread * rendering;
 		Game * game;
+		// The hexagons, drawn once into the board. The first vertex of each is its centre.
 		sf::VertexArray vertices;
 		unsigned int size;
-		mutable sf::Mutex protectVertices;
 		unsigned int width;
 		unsigned int height;
 		float cellSize;
 		float hexagonSize;
+		// Centre of the hexagon (0, 0).
+		sf::Vector2f origin;
 		sf::Texture backgroundTexture;
 		sf::Sprite background;
 		sf::Texture cellTexture;
+		// The background and the hexagons, which never change, drawn once.
+		sf::RenderTexture boardTexture;
+		sf::Sprite board;
 		sf::Texture stoneTexture;
-		std::vector<sf::Sprite> stones;
+		// Every stone as one textured quad, so that they all go in one draw call.
+		sf::VertexArray stones;
+		mutable sf::Mutex protectStones;
+		mutable std::atomic<bool> dirty;
 };
 
 #endif
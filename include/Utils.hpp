@@ -5,12 +5,7 @@
 
 #include <SFML/System.hpp>
 
-enum class Player
-{
-	Empty,
-	AI,
-	Human
-};
+#include "Core.hpp"
 
 enum class GameEventType
 {
@@ -18,18 +13,6 @@ enum class GameEventType
 	Closed
 };
 
-struct Edge
-{
-	Edge()
-	{}
-	Edge(Player _player, sf::Vector2u coor = sf::Vector2u(0, 0)) :
-						player(_player), position(coor)
-	{}
-	
-	Player player;
-	sf::Vector2u position;
-};
-
 struct GameEvent
 {
 	GameEvent() 
@@ -43,30 +26,20 @@ struct GameEvent
 	Player player;
 };
 
-inline Player nextPlayer(Player player)
+inline sf::Vector2u toVector2u(Cell cell)
 {
-	if (player == Player::Human)
-		return Player::AI;
-	if (player == Player::AI)
-		return Player::Human;
-	return Player::Empty;
+	return sf::Vector2u(cell.x, cell.y);
 }
 
-template<typename T>
-inline sf::Vector2<T> makeVector2(std::complex<T> value)
+inline Cell toCell(sf::Vector2u position)
 {
-	return sf::Vector2<T>(value.real(), value.imag());
+	return Cell(position.x, position.y);
 }
 
 template<typename T>
-struct CompareVector2
+inline sf::Vector2<T> makeVector2(std::complex<T> value)
 {
-	bool operator()(const sf::Vector2<T>& left, const sf::Vector2<T>& right) const
-	{
-		if (left.x != right.x)
-			return (left.x < right.x);
-		return (left.y < right.y);
-	}
-};
+	return sf::Vector2<T>(value.real(), value.imag());
+}
 
 #endif
\ No newline at end of file
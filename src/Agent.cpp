@@ -1,187 +1,627 @@
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <chrono>
-#include <fstream>
-#include <random>
+#include <limits>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include "Agent.hpp"
-#include "Game.hpp"
+#include "UCTKernel.hpp"
 
 using namespace std;
-using namespace sf;
 
-#define LOG_TXT
+static const unsigned int checkPeriod = 256;
+static const unsigned int ponderNodes = 1 << 18;
+static const unsigned int defaultTableSize = 16;
+static const unsigned int defaultRave = 1000;
+static const unsigned int expandThreshold = 4;
 
-#ifdef LOG_TXT
-ofstream out("log.txt");
-#endif
+// Value-initialises the first elements of block as an array of T and moves block past them.
+template<typename T>
+static T * construct(char *& block, unsigned int number)
+{
+	T * array = reinterpret_cast<T*>(block);
+	for (unsigned int element = 0; element < number; ++element)
+		new (&array[element]) T();
+	block += number * sizeof(T);
+	return array;
+}
 
-static const unsigned int seed = chrono::system_clock::now().time_since_epoch().count();
-static default_random_engine randGenerator(seed);
-unsigned int nbDescents = 32*1000;
-unsigned int Tree::count = 0;
-unsigned int nbSimulations = 0;
+Agent::Agent(Data * _data, unsigned int _size, Player _self, SearchMode _mode, unsigned int _nbThreads) : 
+size(_size), data(_data), self(_self), mode(_mode), nbThreads(max(_nbThreads, 1u)),
+seed(chrono::system_clock::now().time_since_epoch().count()), raveEquivalence(defaultRave), batchSize(1), nbPlayouts(0), 
+ponderingEnabled(false), pondering(false), stopSearch(false), telemetry(nullptr), book(nullptr), nbReports(0), nodesFreed(0),
+spare(new TreePool()), table(new TranspositionTable(defaultTableSize))
+{
+	if (mode == SearchMode::Sequential)
+		nbThreads = 1;
+	trees.resize(mode == SearchMode::RootParallel ? nbThreads : 1, nullptr);
+	for (unsigned int root = 0; root < trees.size(); ++root)
+		pools.emplace_back(new TreePool());
+}
 
-CompareTree::CompareTree(double _cUCT) : cUCT(_cUCT) 
-{}
- 
-bool CompareTree::operator()(Tree * left, Tree * right) const
+void Agent::pruning(Cell move)
+{
+	stopPondering();
+	
+	for (unsigned int root = 0; root < trees.size(); ++root)
+	{
+		if (trees[root] == nullptr)
+			continue;
+			
+		// The chosen subtree is compacted into the spare arena, then the old arena
+		// (and every discarded sibling with it) is dropped in one go.
+		Tree * child = trees[root]->findChild(move);
+		trees[root] = nullptr;
+		if (child != nullptr)
+			trees[root] = child->copy(nullptr, *spare);
+		nodesFreed += pools[root]->size() - spare->size();
+		pools[root]->reset();
+		swap(pools[root], spare);
+	}
+	if (table != nullptr)
+		table->newGeneration();
+}
+
+void Agent::setLimits(SearchLimits _limits)
+{
+	limits = _limits;
+}
+
+void Agent::setPondering(bool enabled)
+{
+	ponderingEnabled = enabled;
+}
+
+void Agent::setSeed(unsigned int _seed)
+{
+	seed = _seed;
+}
+
+void Agent::setTableSize(unsigned int megabytes)
+{
+	stopPondering();
+	table.reset(megabytes == 0 ? nullptr : new TranspositionTable(megabytes));
+}
+
+void Agent::setRave(unsigned int equivalence)
+{
+	stopPondering();
+	raveEquivalence = equivalence;
+}
+
+void Agent::setBatch(unsigned int size)
+{
+	stopPondering();
+	batchSize = min(max(size, 1u), PlayoutBatch::maxPlayouts);
+}
+
+void Agent::setTelemetry(ostream * stream)
+{
+	telemetry = stream;
+}
+
+void Agent::setBook(const OpeningBook * _book)
 {
-	return left->UCT(cUCT) < right->UCT(cUCT);
+	book = _book;
 }
 
-Agent::Agent(Game * father, Data * _data, unsigned int _size) : game(father), size(_size), data(_data), tree(nullptr)
+unsigned int Agent::playouts() const
 {
-	#ifdef LOG_TXT
-	out.precision(2);
-	out.setf(ios::fixed, ios::floatfield);
-	#endif
+	return nbPlayouts;
 }
 
-void Agent::pruning(Vector2u move, Player player)
+Cell Agent::UCT()
 {
-	if (tree == nullptr)
-		return ;  
+	stopPondering();
+	prepareRoots(self);
 		
-	#ifdef LOG_TXT
-	out.width(6);
-	out << Tree::count << "\t";
-	#endif
-		  
-	Tree * child = tree->findChild(move);
-	tree->clear(child);
-	
-	#ifdef LOG_TXT
-	out.width(6);
-	out << Tree::count << "\t";
-	out.width(6);
-	if (child != nullptr)
-	{
-		double ratio = child->UCT(0);
-		if (player != Player::AI)
-			ratio = 1.0 - ratio;
-		out << ratio*100.0 << " %\t";
-	}
-	else
-		out << "?" << " %\t";
-	out << "Player : " << (player == Player::AI ? "AI" : "Human") << "\n";
-	#endif
+	nbPlayouts = 0;
+	stats.clear();
+	SteadyClock::time_point start = SteadyClock::now();
+	Cell move;
+	if (book == nullptr || !book->find(data->hash(), size, self, move) || !data->isLegal(move))
+	{
+		if (nbThreads == 1)
+			search(trees.front(), *pools.front(), seed++, start);
+		else
+		{
+			vector<thread> workers;
+			launch(workers, start);
+			for (auto& worker : workers)
+				worker.join();
+		}
+		move = bestMove();
+	}
 	
-	delete tree;
-	tree = child;
+	report(move, SteadyClock::now() - start);
+	stopSearch = false;
+	return move;
 }
 
-void Agent::UCT()
+// Searches the opponent's turn in the background, on the trees pruning() will reuse.
+// It runs until stopPondering(), or until the trees reach their node budget.
+void Agent::ponder()
 {
-	if (tree == nullptr)
-		tree = new Tree(nullptr, *data, Vector2u(0, 0), Player::AI);
-	tree->father = nullptr;
+	if (!ponderingEnabled || pondering || data->winner() != Player::Empty)
+		return ;
 		
-	Clock clock;
-	while (clock.getElapsedTime() < seconds(2.5f))
+	prepareRoots(nextPlayer(self));
+	pondering = true;
+	stopSearch = false;
+	launch(ponderers, SteadyClock::now());
+}
+
+void Agent::stopPondering()
+{
+	if (!pondering)
+		return ;
+		
+	stopSearch = true;
+	for (auto& ponderer : ponderers)
+		ponderer.join();
+	ponderers.clear();
+	pondering = false;
+	stopSearch = false;
+}
+
+void Agent::stop()
+{
+	stopSearch = true;
+}
+
+void Agent::resume()
+{
+	stopSearch = false;
+}
+
+void Agent::prepareRoots(Player toMove)
+{
+	for (unsigned int root = 0; root < trees.size(); ++root)
 	{
-		Data board = *data;
-		Tree * sheet = selection(tree, board, Player::AI);
-		Player winner = board.MonteCarlo(sheet->move, nextPlayer(sheet->player));
-		reachBack(sheet, winner);
+		if (trees[root] == nullptr)
+		{
+			trees[root] = pools[root]->createNode();
+			trees[root]->player = nextPlayer(toMove);
+		}
+	}
+}
+
+void Agent::launch(vector<thread>& workers, SteadyClock::time_point start)
+{
+	for (unsigned int worker = 0; worker < nbThreads; ++worker)
+	{
+		Tree * tree = trees[worker % trees.size()];
+		TreePool * pool = pools[worker % trees.size()].get();
+		unsigned int workerSeed = seed++;
+		workers.emplace_back([=]() { search(tree, *pool, workerSeed, start); });
+	}
+}
+
+void Agent::search(Tree * tree, TreePool& pool, unsigned int workerSeed, SteadyClock::time_point start)
+{
+	Worker worker(pool, table.get(), raveEquivalence, workerSeed, batchSize);
+	SearchStats& local = worker.stats;
+	// One board for the whole search, taken back to the root after each descent.
+	// The playouts fill copies of it: a full board costs less to copy than to undo.
+	Data board = *data;
+	unsigned int root = board.nbPlayed();
+	while (!finished(start))
+	{
+		local.nextPlayout();
+		uint64_t mark = local.start();
+		Tree * sheet = selection(tree, board, nextPlayer(tree->player), worker);
+		// A won position needs no more than one playout.
+		bool batched = (worker.batchSize > 1 && board.winner() == Player::Empty);
+		unsigned int done = (batched ? worker.batchSize : 1);
+		local.lap(SearchStats::Selection, mark, done);
+		
+		if (batched)
+		{
+			worker.batch.run(board, sheet->move(), nextPlayer(sheet->player), done, worker.generator, &local);
+			local.lap(SearchStats::Playout, mark, done);
+			reachBack(sheet, worker);
+		}
+		else
+		{
+			Data playout = board;
+			Player winner = playout.MonteCarlo(sheet->move(), nextPlayer(sheet->player), worker.generator, &local);
+			local.lap(SearchStats::Playout, mark);
+			reachBack(sheet, winner, worker, playout);
+		}
+		board.takeBack(root);
+		local.lap(SearchStats::Backpropagation, mark, done);
+		local.playouts += done;
+		nbPlayouts += done;
 	}
 	
-	auto child = *(max_element(tree->childs.begin(), tree->childs.end(), CompareTree(0)));
-	Vector2u bestMove = child->move;
-	game->addEvent(GameEvent(GameEventType::Move, bestMove, Player::AI));  
+	protectStats.lock();
+	stats += local;
+	protectStats.unlock();
+}
+
+bool Agent::finished(SteadyClock::time_point start) const
+{
+	if (stopSearch)
+		return true;
+	if (pondering)
+		return nbNodes() >= (limits.nodes != 0 ? limits.nodes : ponderNodes);
+		
+	// Whatever the limits, the move rests on at least one playout.
+	unsigned int done = nbPlayouts;
+	if (done == 0)
+		return false;
+	if (limits.playouts == 0 && limits.nodes == 0 && limits.time == Seconds::zero())
+		return true;
+	if (limits.playouts != 0 && done >= limits.playouts)
+		return true;
+	if (limits.nodes != 0 && nbNodes() >= limits.nodes)
+		return true;
+		
+	Seconds elapsed = SteadyClock::now() - start;
+	if (limits.time != Seconds::zero() && elapsed >= limits.time)
+		return true;
+	return limits.earlyStop && done % checkPeriod < batchSize && decided(done, elapsed);
+}
+
+bool Agent::decided(unsigned int done, Seconds elapsed) const
+{
+	unsigned int remaining = numeric_limits<unsigned int>::max();
+	if (limits.playouts != 0)
+		remaining = limits.playouts - done;
+	if (limits.time != Seconds::zero() && elapsed > Seconds::zero())
+	{
+		double rate = double(done) / elapsed.count();
+		remaining = min<double>(remaining, rate * (limits.time - elapsed).count());
+	}
+	if (remaining == numeric_limits<unsigned int>::max())
+		return false;
+		
+	vector<unsigned int> visits;
+	rootVisits(visits);
+	unsigned int first = 0, second = 0;
+	for (auto count : visits)
+	{
+		if (count > first)
+		{
+			second = first;
+			first = count;
+		}
+		else if (count > second)
+			second = count;
+	}
+	return first - second > remaining;
+}
+
+unsigned int Agent::nbNodes() const
+{
+	unsigned int result = 0;
+	for (auto& pool : pools)
+		result += pool->size();
+	return result;
+}
+
+// Visits of every move at the root, summed over the trees of root parallelism.
+// The table's priors are left out: every tree got them, and no playout of this
+// search stands behind them.
+void Agent::rootVisits(vector<unsigned int>& visits) const
+{
+	visits.assign(size*size, 0);
+	for (auto root : trees)
+	{
+		root->protect.lock();
+		for (unsigned int child = 0; child < root->nbChilds; ++child)
+			visits[root->moves[child].y*size + root->moves[child].x] += root->visits[child] - root->childs[child]->priorVisits;
+		root->protect.unlock();
+	}
+}
+
+// Playouts won by the player to move after the given root move, over all the trees.
+double Agent::winRate(Cell move) const
+{
+	double nbWins = 0.0, nbVisits = 0.0;
+	for (auto root : trees)
+	{
+		Tree * child = root->findChild(move);
+		if (child != nullptr)
+		{
+			nbWins += root->wins[child->index];
+			nbVisits += root->visits[child->index];
+		}
+	}
+	return nbVisits > 0.0 ? nbWins / nbVisits : 0.0;
+}
+
+void Agent::report(Cell move, Seconds elapsed)
+{
+	if (telemetry == nullptr)
+		return ;
+		
+	MoveReport line;
+	line.move = ++nbReports;
+	line.player = (self == Player::AI ? "AI" : "Human");
+	line.x = move.x;
+	line.y = move.y;
+	line.seconds = elapsed.count();
+	line.winRate = winRate(move);
+	line.nodesAlive = nbNodes();
+	line.nodesFreed = nodesFreed;
+	line.stats = stats;
+	*telemetry << line << endl;
+	nodesFreed = 0;
+}
+
+Cell Agent::bestMove() const
+{
+	vector<unsigned int> visits;
+	rootVisits(visits);
+	unsigned int best = max_element(visits.begin(), visits.end()) - visits.begin();
+	if (visits[best] == 0)
+		return data->moves().front();
+	return Cell(best % size, best / size);
 }
 
 Agent::~Agent()
 {
-	#ifdef LOG_TXT
-	unsigned int unites = nbSimulations % 1000;
-	unsigned int milliers = (nbSimulations / 1000) % 1000;
-	unsigned int millions = (nbSimulations / 1000000);
-	out.fill('0');
-	out << "\n\tNumber of simulations : ";
-	out.width(3);	
-	out << millions << " ";
-	out.width(3);
-	out << milliers << " ";
-	out.width(3);
-	out << unites << "\n";
-	#endif
-	
-	tree->clear(nullptr);
-	delete tree;
+	stopPondering();
 }
 
-Tree * selection(Tree * tree, Data& data, Player current)
+// Visits are counted on the way down and wins on the way up: until reachBack()
+// runs, a pending playout weighs as a loss (virtual loss), so concurrent
+// descents in a shared tree spread over different children. A new node starts
+// with the statistics the table holds for its position, gathered through other
+// move orders or during previous moves.
+Tree * selection(Tree * tree, Data& data, Player current, Worker& worker)
 {
-	if (tree->noMoves.empty() && tree->childs.empty())
+	tree->nbSimulations += 1;
+	
+	tree->protect.lock();
+	if (!tree->expanded && tree->father != nullptr && tree->nbSimulations < expandThreshold)
+	{
+		tree->protect.unlock();
 		return tree;
-		
-	if (!tree->noMoves.empty())
+	}
+	if (!tree->expanded)
 	{
-		Vector2u randomMove = tree->noMoves.back();
-		tree->noMoves.pop_back();
-		data.makeMove(randomMove, current);
+		tree->expand(data, worker.pool, worker.generator);
+		++worker.stats.expansions;
+	}
 		
-		Tree * sheet = new Tree(tree, data, randomMove, current);
-		tree->childs.push_back(sheet);
+	if (tree->nbMoves == 0)
+	{
+		tree->protect.unlock();
+		return tree;
+	}
 		
+	if (tree->nbChilds < tree->nbMoves)
+	{
+		unsigned int child = tree->nbChilds;
+		data.makeMove(tree->moves[child], current);
+		Tree * sheet = worker.pool.createNode();
+		sheet->father = tree;
+		sheet->hash = data.hash();
+		sheet->index = child;
+		sheet->player = current;
+		sheet->nbSimulations = 1;
+		tree->visits[child] = 1;
+		const TranspositionTable::Entry * entry = (worker.table != nullptr ? worker.table->find(sheet->hash) : nullptr);
+		if (entry != nullptr)
+		{
+			sheet->priorVisits = entry->visits;
+			tree->wins[child] += entry->wins;
+			tree->visits[child] += entry->visits;
+		}
+		tree->childs[child] = sheet;
+		++tree->nbChilds;
+		tree->protect.unlock();
 		return sheet;
 	}
 
-	tree = *(max_element(tree->childs.begin(), tree->childs.end(), CompareTree(0.5)));
-	data.makeMove(tree->move, current);
+	// Every move has its child: the arrays no longer change shape, and the
+	// counters are scored without holding the node.
+	unsigned int nbChilds = tree->nbChilds;
+	tree->protect.unlock();
+	unsigned int best = bestUCT(tree->wins, tree->visits, tree->raveWins, tree->raveVisits, nbChilds, 
+	                            0.5f, log(float(tree->nbSimulations)), worker.raveEquivalence);
+	tree->visits[best] += 1;
+	Tree * child = tree->childs[best];
+	data.makeMove(tree->moves[best], current);
+
+	return selection(child, data, nextPlayer(current), worker);
+}
+
+// The finished board is the record of the playout: every stone on it that is a
+// move of a node on the path was played after that node, by the stone's owner.
+void reachBack(Tree * tree, Player current, Worker& worker, const Data& board)
+{
+	unsigned int depth = 0;
+	for (; tree->father != nullptr; tree = tree->father, ++depth)
+	{
+		bool won = (current == tree->player);
+		if (won)
+			tree->father->wins[tree->index] += 1;
+		if (worker.table != nullptr)
+			worker.table->update(tree->hash, won, 1);
+		if (worker.raveEquivalence > 0.0f)
+			updateRave(tree->father, board, current);
+	}
+	
+	worker.stats.depthSum += depth;
+	worker.stats.maxDepth = max(worker.stats.maxDepth, depth);
+}
+
+// The batch adds its playouts in one pass. The descent counted one visit on
+// the way down, the others are added here.
+void reachBack(Tree * tree, Worker& worker)
+{
+	const PlayoutBatch& batch = worker.batch;
+	unsigned int extra = batch.size() - 1;
+	tree->nbSimulations += extra;
+	unsigned int depth = 0;
+	for (; tree->father != nullptr; tree = tree->father, ++depth)
+	{
+		unsigned int wins = batch.wins(tree->player);
+		Tree * father = tree->father;
+		father->nbSimulations += extra;
+		father->visits[tree->index] += extra;
+		father->wins[tree->index] += wins;
+		if (worker.table != nullptr)
+			worker.table->update(tree->hash, wins, batch.size());
+		if (worker.raveEquivalence > 0.0f)
+			updateRave(father, batch);
+	}
+	
+	worker.stats.depthSum += depth;
+	worker.stats.maxDepth = max(worker.stats.maxDepth, depth);
+}
 
-	return selection(tree, data, nextPlayer(current));
+void updateRave(Tree * tree, const Data& board, Player current)
+{
+	Player mover = nextPlayer(tree->player);
+	for (unsigned int child = 0; child < tree->nbMoves; ++child)
+	{
+		if (board(tree->moves[child]) == mover)
+		{
+			tree->raveVisits[child] += 1;
+			if (current == mover)
+				tree->raveWins[child] += 1;
+		}
+	}
 }
 
-void reachBack(Tree * tree, Player current)
+void updateRave(Tree * tree, const PlayoutBatch& batch)
 {
-	while (tree != nullptr)
+	Player mover = nextPlayer(tree->player);
+	for (unsigned int child = 0; child < tree->nbMoves; ++child)
 	{
-		tree->nbSimulations += 1;
-		if (current == tree->player)
-			tree->nbWins += 1;
-		tree = tree->father;
+		unsigned int owned = batch.owned(tree->moves[child], mover);
+		if (owned != 0)
+		{
+			tree->raveVisits[child] += owned;
+			tree->raveWins[child] += batch.ownedWins(tree->moves[child], mover);
+		}
 	}
 }
 
-Tree::Tree(Tree * _father, const Data& data, Vector2u _move, Player current) :
-father(_father), move(_move), player(current), nbWins(0), nbSimulations(0)
-{ 
-	noMoves = data.moves();
-	shuffle(noMoves.begin(), noMoves.end(), randGenerator);
-	++count;
+Tree::Tree() :
+father(nullptr), hash(0), index(0), player(Player::Empty), nbSimulations(0), priorVisits(0), expanded(false), nbChilds(0), nbMoves(0),
+moves(nullptr), wins(nullptr), visits(nullptr), raveWins(nullptr), raveVisits(nullptr), childs(nullptr)
+{}
+
+void Tree::expand(const Data& data, TreePool& pool, RandomEngine& generator)
+{
+	expanded = true;
+	nbMoves = data.nbMoves();
+	if (nbMoves == 0)
+		return ;
+		
+	allocateArrays(pool);
+	data.moves(moves);
+	generator.shuffle(moves, nbMoves);
 }
 
-double Tree::UCT(double cUCT) const
+// All the per-move arrays of the node share one block of the arena, from the most
+// to the least aligned type.
+void Tree::allocateArrays(TreePool& pool)
 {
-	return 
-		double(nbWins) / double(nbSimulations) + 
-		cUCT * sqrt(log(double(father->nbSimulations)) / double(nbSimulations));
+	size_t nbBytes = nbMoves * (sizeof(Tree*) + sizeof(Cell) + 4 * sizeof(atomic<unsigned int>));
+	char * block = static_cast<char*>(pool.allocateBytes(nbBytes, alignof(Tree*)));
+	childs = construct<Tree*>(block, nbMoves);
+	wins = construct<atomic<unsigned int>>(block, nbMoves);
+	visits = construct<atomic<unsigned int>>(block, nbMoves);
+	raveWins = construct<atomic<unsigned int>>(block, nbMoves);
+	raveVisits = construct<atomic<unsigned int>>(block, nbMoves);
+	moves = construct<Cell>(block, nbMoves);
 }
 
-Tree * Tree::findChild(Vector2u move) const
+Tree * Tree::copy(Tree * targetFather, TreePool& pool) const
 {
-	for (auto child : childs)
-		if (child->move == move)
-			return child;
+	Tree * target = pool.createNode();
+	target->father = targetFather;
+	target->hash = hash;
+	target->index = (targetFather == nullptr ? 0 : index);
+	target->player = player;
+	target->nbSimulations = nbSimulations.load();
+	target->priorVisits = priorVisits;
+	target->expanded = expanded;
+	target->nbChilds = nbChilds;
+	target->nbMoves = nbMoves;
+	if (nbMoves == 0)
+		return target;
+		
+	target->allocateArrays(pool);
+	copy_n(moves, nbMoves, target->moves);
+	for (unsigned int move = 0; move < nbMoves; ++move)
+	{
+		target->raveWins[move] = raveWins[move].load();
+		target->raveVisits[move] = raveVisits[move].load();
+	}
+	for (unsigned int child = 0; child < nbChilds; ++child)
+	{
+		target->wins[child] = wins[child].load();
+		target->visits[child] = visits[child].load();
+		target->childs[child] = childs[child]->copy(target, pool);
+	}
+	return target;
+}
+
+Cell Tree::move() const
+{
+	if (father == nullptr)
+		return Cell(0, 0);
+	return father->moves[index];
+}
+
+Tree * Tree::findChild(Cell move) const
+{
+	for (unsigned int child = 0; child < nbChilds; ++child)
+		if (moves[child] == move)
+			return childs[child];
 	return nullptr;
 }
 
-void Tree::clear(Tree * chosen)
+TreePool::TreePool() : nbChunks(0), used(chunkSize), nbNodes(0)
+{}
+
+Tree * TreePool::createNode()
+{
+	Tree * node = allocate<Tree>(1);
+	++nbNodes;
+	return node;
+}
+
+void * TreePool::allocateBytes(size_t nbBytes, size_t alignment)
 {
-	for (auto child : childs)
+	protect.lock();
+	used = (used + alignment - 1) / alignment * alignment;
+	if (used + nbBytes > chunkSize)
 	{
-		if (child != chosen)
-		{
-			child->clear(nullptr);
-			delete child;
-		}
+		if (nbChunks == chunks.size())
+			chunks.emplace_back(new char[chunkSize]);
+		++nbChunks;
+		used = 0;
 	}
+	void * block = &chunks[nbChunks-1][used];
+	used += nbBytes;
+	protect.unlock();
+	return block;
+}
+
+unsigned int TreePool::size() const
+{
+	return nbNodes;
 }
 
-Tree::~Tree()
-{ 
-	--count;
+void TreePool::reset()
+{
+	nbChunks = 0;
+	used = chunkSize;
+	nbNodes = 0;
 }
+
+TreePool::~TreePool()
+{
+	reset();
+}
\ No newline at end of file
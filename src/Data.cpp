@@ -1,208 +1,329 @@
-#include <chrono>
-#include <queue>
-#include <random>
+#include <cassert>
+#include <utility>
 
 #include "Data.hpp"
+#include "Patterns.hpp"
 
 using namespace std;
-using namespace sf;
 
-static const unsigned int seed = chrono::system_clock::now().time_since_epoch().count();
-static default_random_engine randGenerator(seed);
-extern unsigned int nbSimulations;
+// One random key per cell and player, the same for every run and board size.
+struct ZobristKeys
+{
+	ZobristKeys()
+	{
+		RandomEngine generator(0x48657821);
+		for (auto& cell : ai)
+			cell = generator();
+		for (auto& cell : human)
+			cell = generator();
+	}
+	
+	uint64_t ai[Geometry::Top];
+	uint64_t human[Geometry::Top];
+};
+
+static const ZobristKeys zobrist;
+static const Patterns& policy = Patterns::get();
 
-Data::Data(unsigned int _size) : size(_size), board(size*size, Player::Empty)
+Data::Data(unsigned int _size) : size(_size), nbMovesPlayed(0), nbLinks(0), hashKey(0), winnerPlayer(Player::Empty)
 { 
+	assert(size > 0 && size <= maxSize);
+	geometry = &Geometry::get(size);
 	for (unsigned int y = 0; y < size; ++y)
 		for (unsigned int x = 0; x < size; ++x)
-			movesList.emplace(x, y);
+			emptyCells.set(geometry->index(x, y));
+	for (unsigned int node = 0; node < Geometry::NbNodes; ++node)
+	{
+		parent[node] = node;
+		groupSize[node] = 1;
+		codes[node] = (node < Geometry::Top ? geometry->sides[node] : 0);
+	}
+		
+	aiStones.set(Geometry::Top);
+	aiStones.set(Geometry::Bottom);
+	humanStones.set(Geometry::Left);
+	humanStones.set(Geometry::Right);
 }
 
-vector<Vector2u> Data::neighboursCoor(Vector2u position) const
+unsigned int Data::find(unsigned int node) const
 {
-	vector<Vector2u> neighbours;
-	
-	if (position.x > 0)
+	while (parent[node] != node)
+		node = parent[node];
+	return node;
+}
+
+// True when the two groups were apart: the root of the smaller one is then linked
+// under the other and kept on the stack of links. Its own size stays as it was,
+// which is what undo() takes back from the larger group.
+bool Data::merge(unsigned int first, unsigned int second)
+{
+	first = find(first);
+	second = find(second);
+	if (first == second)
+		return false;
+	if (groupSize[first] > groupSize[second])
+		swap(first, second);
+	parent[first] = second;
+	groupSize[second] += groupSize[first];
+	links[nbLinks++] = first;
+	return true;
+}
+
+Player Data::winner() const
+{
+	return winnerPlayer;
+}
+
+uint64_t Data::hash() const
+{
+	return hashKey;
+}
+
+// A full board has exactly one winner, found by a single flood fill once the
+// random fill is over.
+Player Data::MonteCarlo(Cell movePreced, Player current, RandomEngine& generator, SearchStats * stats, Playout * playout)
+{
+	if (winnerPlayer != Player::Empty)
 	{
-		neighbours.emplace_back(position.x-1, position.y);
-		if (position.y < size-1)
-			neighbours.emplace_back(position.x-1, position.y+1);
+		if (playout != nullptr)
+			playout->nbMoves = 0;
+		return winnerPlayer;
 	}
-	
-	if (position.x < size-1)
+		
+	fillAtRandom(movePreced, current, generator, stats, playout);
+	if (stats != nullptr && stats->timeWinner)
 	{
-		neighbours.emplace_back(position.x+1, position.y);
-		if (position.y > 0)
-			neighbours.emplace_back(position.x+1, position.y-1);
+		uint64_t start = SearchStats::now();
+		winnerPlayer = fullBoardWinner();
+		stats->charge(SearchStats::WinnerDetection, start);
+		++stats->samples[SearchStats::WinnerDetection];
 	}
-	
-	if (position.y > 0)
-		neighbours.emplace_back(position.x, position.y-1);
-	if(position.y < size-1)
-		neighbours.emplace_back(position.x, position.y+1);
-		
-	return neighbours;
+	else
+		winnerPlayer = fullBoardWinner();
+	return winnerPlayer;
 }
 
-Player Data::winner() const
+// Random cells are drawn from a buffer on the stack, each one removed as it is
+// drawn, unless a pattern answers the previous move. A cell filled earlier by a
+// pattern answer is still in the buffer and is simply dropped when it comes out.
+// The stones go down without any connection check.
+void Data::fillAtRandom(Cell movePreced, Player current, RandomEngine& generator, SearchStats * stats, Playout * playout)
 {
-	queue<Edge> waitComputed;
-	vector<bool> isComputed(size*size, false);
-	for (unsigned int coor = 0; coor < size; ++coor)
+	if (playout != nullptr)
+		playout->nbMoves = 0;
+		
+	uint16_t cells[Geometry::NbNodes];
+	unsigned int nbCells = 0;
+	emptyCells.forEach([&](unsigned int cell) { cells[nbCells++] = cell; });
+	
+	unsigned int preced = geometry->index(movePreced.x, movePreced.y);
+	while (nbCells > 0)
 	{
-		if (board[coor*size] == Player::Human)
+		unsigned int drawn = generator.below(nbCells);
+		unsigned int move = cells[drawn];
+		if (!emptyCells.test(move))
 		{
-			isComputed[coor*size] = true;
-			waitComputed.emplace(Player::Human, Vector2u(0, coor));
-		}
-		if (board[coor] == Player::AI)
-		{
-			isComputed[coor] = true;
-			waitComputed.emplace(Player::AI, Vector2u(coor, 0));
+			cells[drawn] = cells[--nbCells];
+			continue;
 		}
+		
+		if (!respond(preced, current, generator, move))
+			cells[drawn] = cells[--nbCells];
+		else if (stats != nullptr)
+			++stats->patternAnswers;
+			
+		fill(move, current);
+		if (playout != nullptr)
+			playout->moves[playout->nbMoves++] = geometry->coordinates(move);
+		preced = move;
+		current = nextPlayer(current);
 	}
-	
-	while (!waitComputed.empty())
+}
+
+// Draws an answer to the move among its empty neighbours, in proportion to the
+// weights of their patterns. False when no pattern matches.
+bool Data::respond(unsigned int move, Player current, RandomEngine& generator, unsigned int& answer) const
+{
+	const uint16_t * around = geometry->neighbours[move];
+	unsigned int bounds[6];
+	unsigned int total = 0;
+	for (unsigned int direction = 0; direction < 6; ++direction)
 	{
-		Edge current = waitComputed.front();
-		waitComputed.pop();
+		unsigned int cell = around[direction];
+		if (emptyCells.test(cell))
+			total += policy.weight(codes[cell], Geometry::opposite(direction), current);
+		bounds[direction] = total;
+	}
+	if (total == 0)
+		return false;
 		
-		auto neighbours = neighboursCoor(current.position);
-		for (auto& neighbour : neighbours)
-		{
-			unsigned int x = neighbour.x;
-			unsigned int y = neighbour.y;
-			if (!isComputed[y*size + x] && board[y*size + x] == current.player)
-			{
-				isComputed[y*size + x] = true;
-				waitComputed.emplace(current.player, neighbour);
-			}
-		}
+	unsigned int drawn = generator.below(total);
+	unsigned int direction = 0;
+	while (bounds[direction] <= drawn)
+		++direction;
+	answer = around[direction];
+	return true;
+}
+
+void Data::makeMove(Cell position, Player player)
+{
+	unsigned int cell = geometry->index(position.x, position.y);
+	if (emptyCells.test(cell) && player != Player::Empty)
+		play(cell, player);
+}
+
+void Data::play(unsigned int cell, Player player)
+{
+	Move& move = played[nbMovesPlayed++];
+	move.cell = cell;
+	move.nbLinks = 0;
+	emptyCells.reset(cell);
+	hashKey ^= (player == Player::AI ? zobrist.ai[cell] : zobrist.human[cell]);
+	Plane& friends = (player == Player::AI ? aiStones : humanStones);
+	friends.set(cell);
+		
+	unsigned int code = Patterns::stone(player);
+	for (unsigned int direction = 0; direction < 6; ++direction)
+	{
+		unsigned int neighbour = geometry->neighbours[cell][direction];
+		codes[neighbour] |= code << 2*Geometry::opposite(direction);
+		if (friends.test(neighbour) && merge(cell, neighbour))
+			++move.nbLinks;
 	}
 	
-	for (unsigned int coor = 0; coor < size; ++coor)
+	bool joined = (player == Player::AI ? find(Geometry::Top) == find(Geometry::Bottom)
+	                                    : find(Geometry::Left) == find(Geometry::Right));
+	move.won = (winnerPlayer == Player::Empty && joined);
+	if (move.won)
+		winnerPlayer = player;
+}
+
+// A stone of the playout: the pattern codes follow, the union-find and the hash
+// do not.
+void Data::fill(unsigned int cell, Player player)
+{
+	emptyCells.reset(cell);
+	(player == Player::AI ? aiStones : humanStones).set(cell);
+	unsigned int code = Patterns::stone(player);
+	for (unsigned int direction = 0; direction < 6; ++direction)
+		codes[geometry->neighbours[cell][direction]] |= code << 2*Geometry::opposite(direction);
+}
+
+unsigned int Data::nbPlayed() const
+{
+	return nbMovesPlayed;
+}
+
+void Data::takeBack(unsigned int nbKept)
+{
+	while (nbMovesPlayed > nbKept)
+		undo(played[--nbMovesPlayed]);
+}
+
+// The links of the move are the last ones on their stack. The pattern codes of
+// the sides are never read, so clearing them for one stone is harmless.
+void Data::undo(const Move& move)
+{
+	unsigned int cell = move.cell;
+	hashKey ^= (aiStones.test(cell) ? zobrist.ai[cell] : zobrist.human[cell]);
+	aiStones.reset(cell);
+	humanStones.reset(cell);
+	emptyCells.set(cell);
+	for (unsigned int direction = 0; direction < 6; ++direction)
+		codes[geometry->neighbours[cell][direction]] &= ~(3u << 2*Geometry::opposite(direction));
+	for (unsigned int link = 0; link < move.nbLinks; ++link)
 	{
-		if (board[coor*size + (size-1)] == Player::Human && isComputed[coor*size + (size-1)])
-			return Player::Human;
-		if (board[(size-1)*size + coor] == Player::AI && isComputed[(size-1)*size + coor])
-			return Player::AI;
+		unsigned int root = links[--nbLinks];
+		groupSize[parent[root]] -= groupSize[root];
+		parent[root] = root;
 	}
-	
-	return Player::Empty;
+	if (move.won)
+		winnerPlayer = Player::Empty;
 }
 
-Player Data::MonteCarlo(Vector2u movePreced, Player current)
+// Player::AI wins a full board if its stones join the top to the bottom, and
+// Player::Human otherwise. One flood from the top row, over a stack of cells.
+Player Data::fullBoardWinner() const
 {
-	vector<Vector2u> moves(this->moves());
-	shuffle(moves.begin(), moves.end(), randGenerator);
-	
-	for (auto move : moves)
+	uint16_t stack[Geometry::NbNodes];
+	unsigned int nbStacked = 0;
+	Plane seen;
+	seen.set(Geometry::Top);
+	for (unsigned int x = 0; x < size; ++x)
 	{
-		if (isEmpty(move))
+		unsigned int cell = geometry->index(x, 0);
+		if (aiStones.test(cell))
 		{
-			disconnect(movePreced, current, move);
-			makeMove(move, current);
-			
-			movePreced = move;
-			current = nextPlayer(current);
+			seen.set(cell);
+			stack[nbStacked++] = cell;
 		}
 	}
 	
-	++nbSimulations;
-	return winner();
-}
-
-void Data::disconnect(sf::Vector2u move, Player current, sf::Vector2u& answer) const
-{
-	static const vector<Vector2i> rotations =
-	                   {Vector2i(0, 1), 
-						Vector2i(-1, 1), 
-						Vector2i(-1, 0), 
-						Vector2i(0, -1), 
-						Vector2i(1, -1), 
-						Vector2i(1, 0)};  
-						
-	Vector2i plot1 = Vector2i(move) + Vector2i(1, -1);
-	Vector2i path = Vector2i(move) + Vector2i(1, 0);
-	Vector2i plot2 = Vector2i(move) + Vector2i(0, 1);
-											    
-	for (unsigned int rotation = 0; rotation < rotations.size(); ++rotation)
+	while (nbStacked > 0)
 	{
-		if (diamondPattern(plot1, path, plot2, current))
+		unsigned int cell = stack[--nbStacked];
+		for (auto neighbour : geometry->neighbours[cell])
 		{
-			++nbSimulations;
-			answer = Vector2u(path);
-			return ;
+			if (!aiStones.test(neighbour) || seen.test(neighbour))
+				continue;
+			if (neighbour == Geometry::Bottom)
+				return Player::AI;
+			seen.set(neighbour);
+			stack[nbStacked++] = neighbour;
 		}
-	
-		plot1 += rotations[rotation];
-		path += rotations[(rotation+1)%rotations.size()];
-		plot2 += rotations[(rotation+2)%rotations.size()];
 	}
+	return Player::Human;
 }
 
-bool Data::diamondPattern(Vector2i plot1, Vector2i path, Vector2i plot2, Player current) const
+const Data::Plane& Data::stones(Player player) const
 {
-	if (!correct(path) || !isEmpty(Vector2u(path)))
-		return false;
-		
-	// It is equivalent to "if (current == Human)" 
-	bool pathOk = (path.x == 0) || (path.x == int(size)-1);
-	if (current == Player::AI)
-	{
-		pathOk = (path.y == 0) || (plot1.y == int(size)-1);
-	}
-	
-	bool plot1Ok = pathOk;
-	if (correct(plot1))
-		plot1Ok = (operator()(Vector2u(plot1)) == current);
-		
-	bool plot2Ok = pathOk;
-	if (correct(plot2))
-		plot2Ok = (operator()(Vector2u(plot2)) == current);
-		
-	return (plot1Ok && plot2Ok);
+	return (player == Player::AI ? aiStones : humanStones);
 }
 
-void Data::makeMove(Vector2u position, Player player)
+const Geometry& Data::layout() const
 {
-	operator()(position) = player;
-	auto it = movesList.find(position);
-	if (it != movesList.end())
-		movesList.erase(it);
+	return *geometry;
 }
 
-bool Data::correct(Vector2i test) const
+vector<Cell> Data::moves() const
 {
-	return (test.x >= 0 && test.x < int(size) && test.y >= 0 && test.y < int(size));
+	vector<Cell> result;
+	result.reserve(emptyCells.count());
+	emptyCells.forEach([&](unsigned int cell) { result.push_back(geometry->coordinates(cell)); });
+	return result;
 }
 
-vector<Vector2u> Data::moves() const
+void Data::moves(Cell * result) const
 {
-	return vector<Vector2u>(movesList.begin(), movesList.end());
+	emptyCells.forEach([&](unsigned int cell) { *result++ = geometry->coordinates(cell); });
 }
 
-bool Data::isEmpty(Vector2u position) const
+unsigned int Data::nbMoves() const
 {
-	return operator()(position) == Player::Empty;
+	return emptyCells.count();
 }
 
-Player Data::operator()(unsigned int x, unsigned int y) const
+bool Data::isEmpty(Cell position) const
 {
-	return board[y*size + x];
+	return emptyCells.test(geometry->index(position.x, position.y));
 }
 
-Player& Data::operator()(unsigned int x, unsigned int y)
+bool Data::isLegal(Cell position) const
 {
-	return board[y*size + x];
+	return position.x < size && position.y < size && winnerPlayer == Player::Empty && isEmpty(position);
 }
 
-Player Data::operator()(Vector2u position) const
+Player Data::operator()(unsigned int x, unsigned int y) const
 {
-	return board[position.y*size + position.x];
+	unsigned int cell = geometry->index(x, y);
+	if (aiStones.test(cell))
+		return Player::AI;
+	if (humanStones.test(cell))
+		return Player::Human;
+	return Player::Empty;
 }
 
-Player& Data::operator()(Vector2u position)
+Player Data::operator()(Cell position) const
 {
-	return board[position.y*size + position.x];
-}
\ No newline at end of file
+	return operator()(position.x, position.y);
+}
@@ -1,70 +1,136 @@
+#include <chrono>
+
 #include "Agent.hpp"
 #include "Game.hpp"
 #include "Utils.hpp"
 #include "UserView.hpp"
 
-using namespace sf;
+using namespace std;
+
+// Rest of the main loop when neither the window nor the agent had anything for
+// it, well under one frame.
+static const chrono::milliseconds idlePeriod(4);
 
-Game::Game(unsigned int _size, Player beginner) : 
+Game::Game(unsigned int _size, Player beginner, SearchMode mode, unsigned int nbThreads, const SearchLimits& limits, bool ponder, unsigned int tableSize, unsigned int rave, const string& bookFile) : 
            size(_size), data(_size), currentPlayer(beginner), finish(false),
-		   view(nullptr), agent(new Agent(this, &data, size)) 
-{ }
+		   view(nullptr), agent(new Agent(&data, size, Player::AI, mode, nbThreads)), log("log.txt"), searching(false)
+{ 
+	agent->setLimits(limits);
+	agent->setPondering(ponder);
+	agent->setTableSize(tableSize);
+	agent->setRave(rave);
+	agent->setTelemetry(&log);
+	if (!bookFile.empty() && book.open(bookFile))
+		agent->setBook(&book);
+}
 
+// Called by the window, on the main thread.
 void Game::addEvent(GameEvent event)
 {
-	protectEvents.lock();
+	// The opponent answered (or left): stop searching their turn before the move is played
+	if (event.player != Player::AI)
+		agent->stopPondering();
+		
 	events.push(event);
-	protectEvents.unlock();
 }
 
+// The loop never waits on the search: the window is read, and the answer of the
+// agent played, as soon as they come.
 void Game::launch()
 {
 	view = new UserView(this, size);
 	
 	while (view->isOpen())
 	{
-		if (currentPlayer == Player::Human || finish)
-			view->readUserInput();
-		else
-			agent->UCT();
+		if (!finish && currentPlayer == Player::AI)
+			think();
+		else if (!finish)
+			agent->ponder();
 		
-		processEvent();
+		bool busy = view->readUserInput();
+		busy |= processEvents();
 		
 		if (!finish && data.winner() != Player::Empty)
 			finish = true;
+		if (!busy)
+			this_thread::sleep_for(idlePeriod);
 	}
+	cancel();
 }
 
-void Game::processEvent()
+// Searches the move of the agent on its own thread, which hands it back through
+// answers. The board is not touched until the answer is played.
+void Game::think()
 {
-	protectEvents.lock();
-	
-	GameEvent event;
-	while (!events.empty())
+	if (searching)
+		return ;
+		
+	searching = true;
+	searcher = thread([this]()
 	{
-		event = events.front();
-		events.pop();
+		Cell move = agent->UCT();
+		answers.push(GameEvent(GameEventType::Move, toVector2u(move), Player::AI));
+	});
+}
+
+// Stops the search under way, if any, and drops its answer.
+void Game::cancel()
+{
+	if (!searching)
+		return ;
 		
+	agent->stop();
+	searcher.join();
+	agent->resume();
+	searching = false;
+	GameEvent answer;
+	while (answers.pop(answer))
+	{}
+}
+
+// False when there was nothing to process.
+bool Game::processEvents()
+{
+	bool processed = false;
+	GameEvent event;
+	if (answers.pop(event))
+	{
+		searcher.join();
+		searching = false;
+		play(event);
+		processed = true;
+	}
+	
+	while (events.pop(event))
+	{
 		if (event.type == GameEventType::Closed)
-			view->close();
-			
-		if (event.type == GameEventType::Move 
-		 && data.isEmpty(event.position)
-		 && event.player == currentPlayer
-		 && !finish)
 		{
-			data.makeMove(event.position, currentPlayer);
-			view->setColor(event.position, currentPlayer);
-			agent->pruning(event.position, currentPlayer);
-			currentPlayer = nextPlayer(currentPlayer);
+			cancel();
+			view->close();
 		}
+		play(event);
+		processed = true;
+	}
+	return processed;
+}
+
+void Game::play(const GameEvent& event)
+{
+	if (event.type == GameEventType::Move 
+	 && data.isLegal(toCell(event.position))
+	 && event.player == currentPlayer
+	 && !finish)
+	{
+		data.makeMove(toCell(event.position), currentPlayer);
+		view->setColor(event.position, currentPlayer);
+		agent->pruning(toCell(event.position));
+		currentPlayer = nextPlayer(currentPlayer);
 	}
-	
-	protectEvents.unlock();
 }
 
 Game::~Game()
 {
+	cancel();
 	delete view;
 	delete agent;
 }
@@ -0,0 +1,91 @@
+#include <memory>
+#include <vector>
+
+#include "Geometry.hpp"
+#include "Patterns.hpp"
+
+using namespace std;
+
+struct Offset
+{
+	Offset(int _x, int _y) : x(_x), y(_y)
+	{}
+	
+	Offset& operator+=(const Offset& other)
+	{
+		x += other.x;
+		y += other.y;
+		return *this;
+	}
+	
+	int x;
+	int y;
+};
+
+inline Offset operator+(Offset left, const Offset& right)
+{
+	return left += right;
+}
+
+static const Offset directions[] =
+                   {Offset(1, 0), 
+					Offset(1, -1), 
+					Offset(0, -1), 
+					Offset(-1, 0), 
+					Offset(-1, 1), 
+					Offset(0, 1)};
+
+const Geometry& Geometry::get(unsigned int size)
+{
+	static const vector<unique_ptr<Geometry>> geometries = []()
+	{
+		vector<unique_ptr<Geometry>> result;
+		for (unsigned int size = 0; size <= maxSize; ++size)
+			result.emplace_back(new Geometry(size));
+		return result;
+	}();
+	return *geometries[size];
+}
+
+Geometry::Geometry(unsigned int _size) : size(_size), stride(_size + 1)
+{
+	for (unsigned int cell = 0; cell < Top; ++cell)
+	{
+		sides[cell] = 0;
+		for (unsigned int direction = 0; direction < 6; ++direction)
+			neighbours[cell][direction] = Top;
+	}
+	
+	for (unsigned int y = 0; y < size; ++y)
+	{
+		for (unsigned int x = 0; x < size; ++x)
+		{
+			unsigned int cell = index(x, y);
+			Offset position(x, y);
+			for (unsigned int direction = 0; direction < 6; ++direction)
+			{
+				Offset neighbour = position + directions[direction];
+				unsigned int next = node(neighbour.x, neighbour.y);
+				neighbours[cell][direction] = next;
+				if (next >= Top)
+				{
+					Player owner = (next == Top || next == Bottom ? Player::AI : Player::Human);
+					sides[cell] |= Patterns::stone(owner) << 2*direction;
+				}
+			}
+		}
+	}
+}
+
+unsigned int Geometry::node(int x, int y) const
+{
+	if (y < 0)
+		return Top;
+	if (y >= int(size))
+		return Bottom;
+	if (x < 0)
+		return Left;
+	if (x >= int(size))
+		return Right;
+	return index(x, y);
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "OpeningBook.hpp"
+
+using namespace std;
+
+static const char bookMagic[8] = {'H', 'e', 'x', 'B', 'o', 'o', 'k', '\0'};
+static const uint32_t bookVersion = 1;
+static const uint32_t maxIndexBits = 24;
+
+OpeningBook::OpeningBook() : mapping(nullptr), length(0),
+#ifdef _WIN32
+file(nullptr), fileMapping(nullptr),
+#endif
+header(nullptr), index(nullptr), entries(nullptr)
+{}
+
+bool OpeningBook::open(const string& path)
+{
+	close();
+	if (!map(path))
+		return false;
+
+	header = reinterpret_cast<const Header*>(mapping);
+	if (length < sizeof(Header) || memcmp(header->magic, bookMagic, sizeof(bookMagic)) != 0
+	 || header->version != bookVersion || header->indexBits > maxIndexBits
+	 || length != entriesOffset(header->indexBits) + size_t(header->nbEntries) * sizeof(Entry))
+	{
+		close();
+		return false;
+	}
+
+	index = reinterpret_cast<const uint32_t*>(mapping + sizeof(Header));
+	entries = reinterpret_cast<const Entry*>(mapping + entriesOffset(header->indexBits));
+	if (index[1u << header->indexBits] != header->nbEntries)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool OpeningBook::find(uint64_t hash, unsigned int boardSize, Player player, Cell& move) const
+{
+	if (header == nullptr)
+		return false;
+
+	unsigned int first = bucket(hash, header->indexBits);
+	for (uint32_t entry = index[first]; entry < index[first + 1]; ++entry)
+	{
+		const Entry& candidate = entries[entry];
+		if (candidate.hash == hash && candidate.size == boardSize && candidate.player == uint8_t(player))
+		{
+			move = Cell(candidate.x, candidate.y);
+			return true;
+		}
+	}
+	return false;
+}
+
+unsigned int OpeningBook::size() const
+{
+	return header == nullptr ? 0 : header->nbEntries;
+}
+
+bool OpeningBook::write(const string& path, vector<Entry> book)
+{
+	sort(book.begin(), book.end(), [](const Entry& left, const Entry& right) { return left.hash < right.hash; });
+
+	// About one entry per bucket.
+	unsigned int indexBits = 0;
+	while (indexBits < maxIndexBits && (size_t(1) << indexBits) < book.size())
+		++indexBits;
+	vector<uint32_t> offsets((1u << indexBits) + 1);
+	for (unsigned int b = 0, entry = 0; b < offsets.size(); ++b)
+	{
+		while (entry < book.size() && bucket(book[entry].hash, indexBits) < b)
+			++entry;
+		offsets[b] = entry;
+	}
+
+	Header bookHeader;
+	memcpy(bookHeader.magic, bookMagic, sizeof(bookMagic));
+	bookHeader.version = bookVersion;
+	bookHeader.indexBits = indexBits;
+	bookHeader.nbEntries = book.size();
+	bookHeader.unused = 0;
+
+	ofstream out(path, ios::binary);
+	const char padding[sizeof(uint64_t)] = {};
+	out.write(reinterpret_cast<const char*>(&bookHeader), sizeof(Header));
+	out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+	out.write(padding, entriesOffset(indexBits) - sizeof(Header) - offsets.size() * sizeof(uint32_t));
+	out.write(reinterpret_cast<const char*>(book.data()), book.size() * sizeof(Entry));
+	return bool(out);
+}
+
+OpeningBook::~OpeningBook()
+{
+	close();
+}
+
+void OpeningBook::close()
+{
+	if (mapping != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(mapping);
+		CloseHandle(fileMapping);
+		CloseHandle(file);
+#else
+		munmap(const_cast<char*>(mapping), length);
+#endif
+	}
+	mapping = nullptr;
+	length = 0;
+	header = nullptr;
+	index = nullptr;
+	entries = nullptr;
+}
+
+bool OpeningBook::map(const string& path)
+{
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(handle);
+		return false;
+	}
+	HANDLE mappingHandle = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	const void * view = mappingHandle == nullptr ? nullptr : MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		if (mappingHandle != nullptr)
+			CloseHandle(mappingHandle);
+		CloseHandle(handle);
+		return false;
+	}
+	file = handle;
+	fileMapping = mappingHandle;
+	length = fileSize.QuadPart;
+#else
+	int descriptor = ::open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return false;
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+	{
+		::close(descriptor);
+		return false;
+	}
+	// The mapping outlives the descriptor.
+	void * view = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+	::close(descriptor);
+	if (view == MAP_FAILED)
+		return false;
+	length = status.st_size;
+#endif
+	mapping = static_cast<const char*>(view);
+	return true;
+}
+
+unsigned int OpeningBook::bucket(uint64_t hash, unsigned int indexBits)
+{
+	return indexBits == 0 ? 0 : hash >> (64 - indexBits);
+}
+
+size_t OpeningBook::entriesOffset(unsigned int indexBits)
+{
+	size_t end = sizeof(Header) + ((size_t(1) << indexBits) + 1) * sizeof(uint32_t);
+	return (end + alignof(Entry) - 1) / alignof(Entry) * alignof(Entry);
+}
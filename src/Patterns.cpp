@@ -0,0 +1,62 @@
+#include <algorithm>
+
+#include "Patterns.hpp"
+
+using namespace std;
+
+// The six neighbours of the answer, turning around it from the move just played:
+// F a friendly stone or side, E an enemy one, . an empty cell, * anything. Every
+// pattern also matches mirrored, and a code takes the weight of its best pattern.
+struct Pattern
+{
+	const char * ring;
+	unsigned int weight;
+};
+
+static const Pattern patterns[] =
+{
+	// The move entered the carrier of a bridge, or of the bridge of a stone to its
+	// side (edge template II): the other carrier cell keeps the connection.
+	{"EF***F", 16}
+};
+
+static bool matches(const char * ring, unsigned int code, Player toMove)
+{
+	unsigned int friends = Patterns::stone(toMove);
+	unsigned int enemies = Patterns::stone(nextPlayer(toMove));
+	for (unsigned int slot = 0; slot < 6; ++slot)
+	{
+		unsigned int neighbour = (code >> 2*slot) & 3;
+		if ((ring[slot] == 'F' && neighbour != friends)
+		 || (ring[slot] == 'E' && neighbour != enemies)
+		 || (ring[slot] == '.' && neighbour != 0))
+			return false;
+	}
+	return true;
+}
+
+const Patterns& Patterns::get()
+{
+	static const Patterns table;
+	return table;
+}
+
+Patterns::Patterns()
+{
+	const Player players[] = {Player::AI, Player::Human};
+	for (unsigned int side = 0; side < 2; ++side)
+	{
+		for (unsigned int code = 0; code < nbCodes; ++code)
+		{
+			weights[side][code] = 0;
+			for (auto& pattern : patterns)
+			{
+				char mirror[6];
+				for (unsigned int slot = 0; slot < 6; ++slot)
+					mirror[slot] = pattern.ring[(6 - slot) % 6];
+				if (matches(pattern.ring, code, players[side]) || matches(mirror, code, players[side]))
+					weights[side][code] = max<unsigned int>(weights[side][code], pattern.weight);
+			}
+		}
+	}
+}
@@ -0,0 +1,176 @@
+#include <algorithm>
+
+#include "PlayoutBatch.hpp"
+
+using namespace std;
+
+const unsigned int PlayoutBatch::maxPlayouts;
+
+PlayoutBatch::PlayoutBatch() : geometry(nullptr), nbPlayouts(0), aiWins(0), nbUsed(0)
+{}
+
+void PlayoutBatch::run(const Data& data, Cell move, Player current, unsigned int number, RandomEngine& generator, SearchStats * stats)
+{
+	prepare(data.layout());
+	nbPlayouts = min(number, maxPlayouts);
+	for (unsigned int board = 0; board < nbPlayouts; ++board)
+	{
+		Data copy = data;
+		copy.fillAtRandom(move, current, generator, stats);
+		const Data::Plane& ai = copy.stones(Player::AI);
+		for (unsigned int word = 0; word < nbUsed; ++word)
+			stones[word][board] = ai.word(word) & cells[word];
+	}
+	// The lanes past the last board flood nothing.
+	for (unsigned int board = nbPlayouts; board % lanes != 0; ++board)
+		for (unsigned int word = 0; word < nbUsed; ++word)
+			stones[word][board] = 0;
+
+	if (stats != nullptr && stats->timeWinner)
+	{
+		uint64_t start = SearchStats::now();
+		findWinners();
+		stats->charge(SearchStats::WinnerDetection, start);
+		stats->samples[SearchStats::WinnerDetection] += nbPlayouts;
+	}
+	else
+		findWinners();
+	count();
+}
+
+void PlayoutBatch::prepare(const Geometry& layout)
+{
+	if (geometry == &layout)
+		return ;
+
+	geometry = &layout;
+	nbUsed = (geometry->index(geometry->size - 1, geometry->size - 1) + 64) / 64;
+	for (unsigned int word = 0; word < nbWords; ++word)
+	{
+		cells[word] = 0;
+		topRow[word] = 0;
+		bottomRow[word] = 0;
+	}
+	for (unsigned int y = 0; y < geometry->size; ++y)
+	{
+		for (unsigned int x = 0; x < geometry->size; ++x)
+		{
+			unsigned int cell = geometry->index(x, y);
+			uint64_t bit = uint64_t(1) << (cell % 64);
+			cells[cell / 64] |= bit;
+			if (y == 0)
+				topRow[cell / 64] |= bit;
+			if (y == geometry->size - 1)
+				bottomRow[cell / 64] |= bit;
+		}
+	}
+}
+
+// Grows the Player::AI stones reached from the top row until no board of the
+// group changes or all of them touch the bottom row. Each pass runs the reach to
+// the end of its row segments in one addition, whose carry goes through a
+// segment of stones and stops at the first other cell, then steps once in the
+// other directions, each step on the planes already grown. The padding column
+// keeps the rows apart. The lanes are the innermost loops, with the same work
+// on every board.
+void PlayoutBatch::findWinners()
+{
+	const unsigned int stride = geometry->stride;
+	aiWins = 0;
+	for (unsigned int first = 0; first < nbPlayouts; first += lanes)
+	{
+		Planes own, reach;
+		for (unsigned int word = 0; word < nbUsed; ++word)
+		{
+			for (unsigned int lane = 0; lane < lanes; ++lane)
+			{
+				own[word][lane] = stones[word][first + lane];
+				reach[word][lane] = own[word][lane] & topRow[word];
+			}
+		}
+
+		bool running = true;
+		while (running)
+		{
+			Planes before;
+			uint64_t carry[lanes] = {};
+			for (unsigned int word = 0; word < nbUsed; ++word)
+			{
+				for (unsigned int lane = 0; lane < lanes; ++lane)
+				{
+					before[word][lane] = reach[word][lane];
+					uint64_t sum = own[word][lane] + reach[word][lane];
+					uint64_t total = sum + carry[lane];
+					carry[lane] = (sum < own[word][lane]) | (total < sum);
+					reach[word][lane] |= own[word][lane] & ~total;
+				}
+			}
+			// Down, down-left and left, from the first word to the last.
+			for (unsigned int word = 0; word < nbUsed; ++word)
+			{
+				for (unsigned int lane = 0; lane < lanes; ++lane)
+				{
+					uint64_t grown = (reach[word][lane] << stride) | (reach[word][lane] << (stride - 1)) | (reach[word][lane] >> 1);
+					if (word > 0)
+						grown |= (reach[word - 1][lane] >> (64 - stride)) | (reach[word - 1][lane] >> (65 - stride));
+					if (word + 1 < nbUsed)
+						grown |= reach[word + 1][lane] << 63;
+					reach[word][lane] |= grown & own[word][lane];
+				}
+			}
+			// Up and up-right, from the last word to the first.
+			for (unsigned int word = nbUsed; word-- > 0; )
+			{
+				for (unsigned int lane = 0; lane < lanes; ++lane)
+				{
+					uint64_t grown = (reach[word][lane] >> stride) | (reach[word][lane] >> (stride - 1));
+					if (word + 1 < nbUsed)
+						grown |= (reach[word + 1][lane] << (64 - stride)) | (reach[word + 1][lane] << (65 - stride));
+					reach[word][lane] |= grown & own[word][lane];
+				}
+			}
+
+			uint64_t changed[lanes] = {}, bottom[lanes] = {};
+			for (unsigned int word = 0; word < nbUsed; ++word)
+			{
+				for (unsigned int lane = 0; lane < lanes; ++lane)
+				{
+					changed[lane] |= reach[word][lane] ^ before[word][lane];
+					bottom[lane] |= reach[word][lane] & bottomRow[word];
+				}
+			}
+			running = false;
+			for (unsigned int lane = 0; lane < lanes; ++lane)
+				running |= (changed[lane] != 0 && bottom[lane] == 0);
+		}
+
+		for (unsigned int lane = 0; lane < lanes && first + lane < nbPlayouts; ++lane)
+		{
+			uint64_t bottom = 0;
+			for (unsigned int word = 0; word < nbUsed; ++word)
+				bottom |= reach[word][lane] & bottomRow[word];
+			aiWon[first + lane] = (bottom != 0);
+			aiWins += aiWon[first + lane];
+		}
+	}
+}
+
+void PlayoutBatch::count()
+{
+	fill_n(aiOwned, Geometry::Top, 0);
+	fill_n(aiOwnedWins, Geometry::Top, 0);
+	for (unsigned int board = 0; board < nbPlayouts; ++board)
+	{
+		for (unsigned int word = 0; word < nbUsed; ++word)
+		{
+			uint64_t value = stones[word][board];
+			while (value != 0)
+			{
+				unsigned int cell = word * 64 + __builtin_ctzll(value);
+				++aiOwned[cell];
+				aiOwnedWins[cell] += aiWon[board];
+				value &= value - 1;
+			}
+		}
+	}
+}
@@ -1 +1 @@
-#include "UserView.hpp"#include "RenderingView.hpp"using namespace sf;extern Mutex protectWindow;RenderingView::RenderingView(RenderWindow * target, const UserView * drawing) :                                      window(target),            view(drawing){ 	window->setFramerateLimit(30);}void RenderingView::operator()() const{	while (window->isOpen())	{		window->clear();		window->draw(*view);		window->display();	}}
\ No newline at end of file
+#include "UserView.hpp"#include "RenderingView.hpp"using namespace sf;extern Mutex protectWindow;static const unsigned int framerate = 30;RenderingView::RenderingView(RenderWindow * target, const UserView * drawing) :                                      window(target),            view(drawing){ 	window->setFramerateLimit(framerate);}// A frame is drawn only when the view changed: an idle board costs nothing.void RenderingView::operator()() const{	while (window->isOpen())	{		if (!view->hasChanged())		{			sleep(milliseconds(1000 / framerate));			continue;		}		window->clear();		window->draw(*view);		window->display();	}}
\ No newline at end of file
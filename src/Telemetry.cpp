@@ -0,0 +1,97 @@
+#include "Telemetry.hpp"
+
+using namespace std;
+
+SearchStats::SearchStats()
+{
+	clear();
+}
+
+void SearchStats::clear()
+{
+	playouts = 0;
+	descents = 0;
+	expansions = 0;
+	patternAnswers = 0;
+	depthSum = 0;
+	maxDepth = 0;
+	timePhases = false;
+	timeWinner = false;
+	for (unsigned int phase = 0; phase < NbPhases; ++phase)
+	{
+		samples[phase] = 0;
+		nanoseconds[phase] = 0;
+	}
+}
+
+SearchStats& SearchStats::operator+=(const SearchStats& other)
+{
+	playouts += other.playouts;
+	descents += other.descents;
+	expansions += other.expansions;
+	patternAnswers += other.patternAnswers;
+	depthSum += other.depthSum;
+	if (other.maxDepth > maxDepth)
+		maxDepth = other.maxDepth;
+	for (unsigned int phase = 0; phase < NbPhases; ++phase)
+	{
+		samples[phase] += other.samples[phase];
+		nanoseconds[phase] += other.nanoseconds[phase];
+	}
+	return *this;
+}
+
+void SearchStats::nextPlayout()
+{
+	timePhases = (descents % samplePeriod == 0);
+	timeWinner = (descents % samplePeriod == samplePeriod / 2);
+	++descents;
+}
+
+void SearchStats::charge(Phase phase, uint64_t start)
+{
+	static const uint64_t cost = clockCost();
+	uint64_t elapsed = now() - start;
+	nanoseconds[phase] += (elapsed > cost ? elapsed - cost : 0);
+}
+
+uint64_t SearchStats::clockCost()
+{
+	static const unsigned int nbReads = 1000;
+	uint64_t start = now();
+	for (unsigned int read = 1; read < nbReads; ++read)
+		now();
+	return (now() - start) / nbReads;
+}
+
+double SearchStats::estimate(Phase phase) const
+{
+	if (samples[phase] == 0)
+		return 0.0;
+	return double(nanoseconds[phase]) / double(samples[phase]) * double(playouts) * 1e-9;
+}
+
+ostream& operator<<(ostream& out, const MoveReport& report)
+{
+	const SearchStats& stats = report.stats;
+	out << "{\"move\":" << report.move
+	    << ",\"player\":\"" << report.player << "\""
+	    << ",\"x\":" << report.x
+	    << ",\"y\":" << report.y
+	    << ",\"seconds\":" << report.seconds
+	    << ",\"win_rate\":" << report.winRate
+	    << ",\"playouts\":" << stats.playouts
+	    << ",\"playouts_per_second\":" << (report.seconds > 0.0 ? stats.playouts / report.seconds : 0.0)
+	    << ",\"expansions\":" << stats.expansions
+	    << ",\"pattern_answers\":" << stats.patternAnswers
+	    << ",\"nodes_alive\":" << report.nodesAlive
+	    << ",\"nodes_freed\":" << report.nodesFreed
+	    << ",\"max_depth\":" << stats.maxDepth
+	    << ",\"mean_depth\":" << (stats.descents > 0 ? double(stats.depthSum) / stats.descents : 0.0)
+	    << ",\"selection_seconds\":" << stats.estimate(SearchStats::Selection)
+	    << ",\"playout_seconds\":" << stats.estimate(SearchStats::Playout)
+	    << ",\"winner_detection_seconds\":" << stats.estimate(SearchStats::WinnerDetection)
+	    << ",\"backpropagation_seconds\":" << stats.estimate(SearchStats::Backpropagation)
+	    << "}";
+	return out;
+}
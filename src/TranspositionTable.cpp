@@ -0,0 +1,75 @@
+#include "TranspositionTable.hpp"
+
+using namespace std;
+
+TranspositionTable::TranspositionTable(unsigned int megabytes) : nbBuckets(1), generation(0)
+{
+	size_t capacity = (size_t(megabytes) << 20) / sizeof(Bucket);
+	while (nbBuckets * 2 <= capacity)
+		nbBuckets *= 2;
+	buckets.reset(new Bucket[nbBuckets]);
+}
+
+const TranspositionTable::Entry * TranspositionTable::find(uint64_t hash) const
+{
+	for (auto& entry : bucket(hash).entries)
+		if (matches(entry, hash))
+			return &entry;
+	return nullptr;
+}
+
+void TranspositionTable::update(uint64_t hash, unsigned int wins, unsigned int visits)
+{
+	uint64_t key = (hash & ~generationMask) | generation;
+	Entry * victim = nullptr;
+	bool victimOld = false;
+	for (auto& entry : bucket(hash).entries)
+	{
+		if (matches(entry, hash))
+		{
+			entry.key = key;
+			entry.visits += visits;
+			entry.wins += wins;
+			return ;
+		}
+		
+		// Free entries first, then the ones of an older search, the least visited one
+		// among them.
+		uint64_t current = entry.key;
+		if (current == 0)
+		{
+			victim = &entry;
+			break;
+		}
+		bool old = (current & generationMask) != generation;
+		if (victim == nullptr || (old && !victimOld) || (old == victimOld && entry.visits < victim->visits))
+		{
+			victim = &entry;
+			victimOld = old;
+		}
+	}
+	
+	victim->key = key;
+	victim->visits = visits;
+	victim->wins = wins;
+}
+
+void TranspositionTable::newGeneration()
+{
+	generation = (generation + 1) & generationMask;
+}
+
+size_t TranspositionTable::size() const
+{
+	return nbBuckets * bucketSize;
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucket(uint64_t hash) const
+{
+	return buckets[(hash >> 8) & (nbBuckets - 1)];
+}
+
+bool TranspositionTable::matches(const Entry& entry, uint64_t hash)
+{
+	return (entry.key & ~generationMask) == (hash & ~generationMask);
+}
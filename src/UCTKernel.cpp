@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Geometry.hpp"
+#include "UCTKernel.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// Most children a node can have.
+static const unsigned int maxChilds = Geometry::maxSize * Geometry::maxSize;
+
+struct Arrays
+{
+	const unsigned int * wins;
+	const unsigned int * visits;
+	const unsigned int * raveWins;
+	const unsigned int * raveVisits;
+};
+
+typedef unsigned int (*Kernel)(const Arrays&, unsigned int, float, float, float);
+
+// A child without any AMAF sample gets beta = 0, so its AMAF ratio is never read
+// as 0/0. With raveEquivalence = 0 the score is plain UCT.
+static inline float score(const Arrays& arrays, unsigned int child, float cUCT, float logFather, float raveEquivalence)
+{
+	float visits = float(arrays.visits[child]);
+	float raveVisits = float(arrays.raveVisits[child]);
+	float inverse = 1.0f / visits;
+	float value = float(arrays.wins[child]) * inverse;
+	float equivalence = (raveVisits > 0.0f ? raveEquivalence : 0.0f);
+	float beta = sqrt(equivalence / (3.0f * visits + equivalence));
+	float rave = float(arrays.raveWins[child]) / max(raveVisits, 1.0f);
+	return value + beta * (rave - value) + cUCT * sqrt(logFather * inverse);
+}
+
+// Scans [begin, nbChilds), keeping best unless a child strictly beats bestScore.
+static unsigned int scanScalar(const Arrays& arrays, unsigned int nbChilds, float cUCT, float logFather, 
+                               float raveEquivalence, unsigned int begin, unsigned int best, float bestScore)
+{
+	for (unsigned int child = begin; child < nbChilds; ++child)
+	{
+		float current = score(arrays, child, cUCT, logFather, raveEquivalence);
+		if (current > bestScore)
+		{
+			bestScore = current;
+			best = child;
+		}
+	}
+	return best;
+}
+
+static unsigned int bestScalar(const Arrays& arrays, unsigned int nbChilds, float cUCT, float logFather, 
+                               float raveEquivalence)
+{
+	return scanScalar(arrays, nbChilds, cUCT, logFather, raveEquivalence, 0, 0, -numeric_limits<float>::infinity());
+}
+
+#ifdef HEX_X86_KERNELS
+
+template<unsigned int NbLanes>
+static unsigned int reduceLanes(const float * scores, const int * indices, unsigned int best, float& bestScore)
+{
+	for (unsigned int lane = 0; lane < NbLanes; ++lane)
+	{
+		if (scores[lane] > bestScore || (scores[lane] == bestScore && unsigned(indices[lane]) < best))
+		{
+			bestScore = scores[lane];
+			best = indices[lane];
+		}
+	}
+	return best;
+}
+
+__attribute__((target("avx2")))
+static unsigned int bestAVX2(const Arrays& arrays, unsigned int nbChilds, float cUCT, float logFather, 
+                             float raveEquivalence)
+{
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 three = _mm256_set1_ps(3.0f);
+	const __m256 equivalence = _mm256_set1_ps(raveEquivalence);
+	const __m256 exploration = _mm256_set1_ps(cUCT);
+	const __m256 logarithm = _mm256_set1_ps(logFather);
+	const __m256i step = _mm256_set1_epi32(8);
+	__m256 bestScores = _mm256_set1_ps(-numeric_limits<float>::infinity());
+	__m256i bestIndices = _mm256_setzero_si256();
+	__m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	
+	unsigned int child = 0;
+	for (; child + 8 <= nbChilds; child += 8)
+	{
+		__m256 nbVisits = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(arrays.visits + child)));
+		__m256 nbWins = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(arrays.wins + child)));
+		__m256 raveVisits = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(arrays.raveVisits + child)));
+		__m256 raveWins = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(arrays.raveWins + child)));
+		__m256 inverse = _mm256_div_ps(one, nbVisits);
+		__m256 value = _mm256_mul_ps(nbWins, inverse);
+		__m256 weight = _mm256_and_ps(_mm256_cmp_ps(raveVisits, zero, _CMP_GT_OQ), equivalence);
+		__m256 beta = _mm256_sqrt_ps(_mm256_div_ps(weight, _mm256_add_ps(_mm256_mul_ps(three, nbVisits), weight)));
+		__m256 rave = _mm256_div_ps(raveWins, _mm256_max_ps(raveVisits, one));
+		value = _mm256_add_ps(value, _mm256_mul_ps(beta, _mm256_sub_ps(rave, value)));
+		__m256 scores = _mm256_add_ps(value, 
+		                _mm256_mul_ps(exploration, _mm256_sqrt_ps(_mm256_mul_ps(logarithm, inverse))));
+		__m256 better = _mm256_cmp_ps(scores, bestScores, _CMP_GT_OQ);
+		bestScores = _mm256_blendv_ps(bestScores, scores, better);
+		bestIndices = _mm256_blendv_epi8(bestIndices, indices, _mm256_castps_si256(better));
+		indices = _mm256_add_epi32(indices, step);
+	}
+	
+	float scores[8];
+	int lanes[8];
+	_mm256_storeu_ps(scores, bestScores);
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), bestIndices);
+	float bestScore = -numeric_limits<float>::infinity();
+	unsigned int best = reduceLanes<8>(scores, lanes, 0, bestScore);
+	
+	return scanScalar(arrays, nbChilds, cUCT, logFather, raveEquivalence, child, best, bestScore);
+}
+
+__attribute__((target("sse2")))
+static unsigned int bestSSE2(const Arrays& arrays, unsigned int nbChilds, float cUCT, float logFather, 
+                             float raveEquivalence)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 three = _mm_set1_ps(3.0f);
+	const __m128 equivalence = _mm_set1_ps(raveEquivalence);
+	const __m128 exploration = _mm_set1_ps(cUCT);
+	const __m128 logarithm = _mm_set1_ps(logFather);
+	const __m128i step = _mm_set1_epi32(4);
+	__m128 bestScores = _mm_set1_ps(-numeric_limits<float>::infinity());
+	__m128i bestIndices = _mm_setzero_si128();
+	__m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+	
+	unsigned int child = 0;
+	for (; child + 4 <= nbChilds; child += 4)
+	{
+		__m128 nbVisits = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(arrays.visits + child)));
+		__m128 nbWins = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(arrays.wins + child)));
+		__m128 raveVisits = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(arrays.raveVisits + child)));
+		__m128 raveWins = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(arrays.raveWins + child)));
+		__m128 inverse = _mm_div_ps(one, nbVisits);
+		__m128 value = _mm_mul_ps(nbWins, inverse);
+		__m128 weight = _mm_and_ps(_mm_cmpgt_ps(raveVisits, zero), equivalence);
+		__m128 beta = _mm_sqrt_ps(_mm_div_ps(weight, _mm_add_ps(_mm_mul_ps(three, nbVisits), weight)));
+		__m128 rave = _mm_div_ps(raveWins, _mm_max_ps(raveVisits, one));
+		value = _mm_add_ps(value, _mm_mul_ps(beta, _mm_sub_ps(rave, value)));
+		__m128 scores = _mm_add_ps(value, 
+		                _mm_mul_ps(exploration, _mm_sqrt_ps(_mm_mul_ps(logarithm, inverse))));
+		__m128 better = _mm_cmpgt_ps(scores, bestScores);
+		bestScores = _mm_or_ps(_mm_and_ps(better, scores), _mm_andnot_ps(better, bestScores));
+		__m128i mask = _mm_castps_si128(better);
+		bestIndices = _mm_or_si128(_mm_and_si128(mask, indices), _mm_andnot_si128(mask, bestIndices));
+		indices = _mm_add_epi32(indices, step);
+	}
+	
+	float scores[4];
+	int lanes[4];
+	_mm_storeu_ps(scores, bestScores);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), bestIndices);
+	float bestScore = -numeric_limits<float>::infinity();
+	unsigned int best = reduceLanes<4>(scores, lanes, 0, bestScore);
+	
+	return scanScalar(arrays, nbChilds, cUCT, logFather, raveEquivalence, child, best, bestScore);
+}
+
+#endif
+
+static Kernel chooseKernel()
+{
+	#ifdef HEX_X86_KERNELS
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return bestAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return bestSSE2;
+	#endif
+	return bestScalar;
+}
+
+unsigned int bestUCT(const atomic<unsigned int> * wins, const atomic<unsigned int> * visits, 
+                     const atomic<unsigned int> * raveWins, const atomic<unsigned int> * raveVisits, 
+                     unsigned int nbChilds, float cUCT, float logFather, float raveEquivalence)
+{
+	static const Kernel kernel = chooseKernel();
+	// The other search threads keep counting while the kernel runs: it scores a
+	// copy, which a racing increment only leaves one visit stale.
+	unsigned int snapshot[4][maxChilds];
+	for (unsigned int child = 0; child < nbChilds; ++child)
+	{
+		snapshot[0][child] = wins[child].load(memory_order_relaxed);
+		snapshot[1][child] = visits[child].load(memory_order_relaxed);
+		snapshot[2][child] = raveWins[child].load(memory_order_relaxed);
+		snapshot[3][child] = raveVisits[child].load(memory_order_relaxed);
+	}
+	Arrays arrays;
+	arrays.wins = snapshot[0];
+	arrays.visits = snapshot[1];
+	arrays.raveWins = snapshot[2];
+	arrays.raveVisits = snapshot[3];
+	return kernel(arrays, nbChilds, cUCT, logFather, raveEquivalence);
+}
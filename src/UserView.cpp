@@ -2,7 +2,6 @@
 #include <chrono>
 #include <cmath>
 #include <complex>
-#include <random>
 
 #include "Game.hpp"
 #include "RenderingView.hpp"
@@ -18,7 +17,7 @@ static const complex<float> twoHours = polar<float>(1.0, pi / 3.0);
 static const Color AIColor(80, 80, 80, 255);
 
 UserView::UserView(Game * father, unsigned int dataSize) : 
- window(nullptr), rendering(nullptr), game(father), size(dataSize)
+ window(nullptr), rendering(nullptr), game(father), size(dataSize), stones(Quads), dirty(true)
 { 
 	width = VideoMode::getDesktopMode().width;
 	height = VideoMode::getDesktopMode().height;
@@ -31,6 +30,7 @@ UserView::UserView(Game * father, unsigned int dataSize) :
 	stoneTexture.setSmooth(true);
 	initBackground();
 	initHexagons();
+	initBoard();
 	initSide();
 
 	sf::ContextSettings settings;
@@ -42,25 +42,33 @@ UserView::UserView(Game * father, unsigned int dataSize) :
 	rendering->launch();
 }
 
+// The centres of the hexagons are origin + (x + y, x - y) * (1.5, sqrt3/2) * cellSize
+// (see initHexagons()). The click is brought back to fractional coordinates,
+// rounded to the nearest hexagon through the cube coordinates (x, y, -x-y), and
+// kept if it falls inside that hexagon.
 bool UserView::collision(unsigned int xMouse, unsigned int yMouse, Vector2u& position) const
 {
-	Lock lock(protectVertices);
-	for (unsigned int y = 0; y < size; ++y)
-	{
-		for (unsigned int x = 0; x < size; ++x)
-		{
-			const Vertex * hexagon = &vertices[index(x, y)];
-			float deltaX = hexagon[0].position.x - float(xMouse);
-			float deltaY = hexagon[0].position.y - float(yMouse);
-			if (sqrt(deltaX*deltaX + deltaY*deltaY) <= (sqrt3/2.)*hexagonSize)
-			{
-				position = Vector2u(x, y);
-				return true;
-			}
-		}
-	}
+	float sum = (float(xMouse) - origin.x) / (1.5 * cellSize);
+	float difference = (float(yMouse) - origin.y) / ((sqrt3/2.) * cellSize);
+	float x = (sum + difference) / 2.0;
+	float y = (sum - difference) / 2.0;
+	float z = -x - y;
 	
-	return false;
+	float xRound = round(x), yRound = round(y), zRound = round(z);
+	float xError = abs(xRound - x), yError = abs(yRound - y), zError = abs(zRound - z);
+	if (xError > yError && xError > zError)
+		xRound = -yRound - zRound;
+	else if (yError > zError)
+		yRound = -xRound - zRound;
+	if (xRound < 0 || yRound < 0 || xRound >= size || yRound >= size)
+		return false;
+		
+	float deltaX = origin.x + 1.5 * cellSize * (xRound + yRound) - float(xMouse);
+	float deltaY = origin.y + (sqrt3/2.) * cellSize * (xRound - yRound) - float(yMouse);
+	if (sqrt(deltaX*deltaX + deltaY*deltaY) > (sqrt3/2.)*hexagonSize)
+		return false;
+	position = Vector2u(xRound, yRound);
+	return true;
 }
 
 void UserView::close()
@@ -70,32 +78,40 @@ void UserView::close()
 		window->close();
 }
 
-Sprite UserView::createStone(Vector2f position) const
+void UserView::addStone(Vector2f position, Color color)
 {
-	return createStone(position.x, position.y);
+	addStone(position.x, position.y, color);
 }
 
-Sprite UserView::createStone(float x, float y) const
+// A quad of the whole stone texture, 1.45 cells wide, centred on the position.
+void UserView::addStone(float x, float y, Color color)
 {
-	Sprite stone;
-	stone.setTexture(stoneTexture);
-	stone.setOrigin(Vector2f(stoneTexture.getSize().x, stoneTexture.getSize().y) * 0.5f);
-	stone.setScale(1.45 * (cellSize / float(stoneTexture.getSize().x)), 
-	               1.45 * (cellSize / float(stoneTexture.getSize().y)));
-	stone.setPosition(x, y);
-	return stone;
+	float half = 0.725 * cellSize;
+	float xTexture = stoneTexture.getSize().x;
+	float yTexture = stoneTexture.getSize().y;
+	protectStones.lock();
+	stones.append(Vertex(Vector2f(x - half, y - half), color, Vector2f(0, 0)));
+	stones.append(Vertex(Vector2f(x + half, y - half), color, Vector2f(xTexture, 0)));
+	stones.append(Vertex(Vector2f(x + half, y + half), color, Vector2f(xTexture, yTexture)));
+	stones.append(Vertex(Vector2f(x - half, y + half), color, Vector2f(0, yTexture)));
+	protectStones.unlock();
+	dirty = true;
 }
 
+// Two draw calls, whatever the number of stones.
 void UserView::draw(RenderTarget& target, RenderStates states) const
 {
 	states.transform *= getTransform();
-	target.draw(background, states);
-	states.texture = &cellTexture;
-	protectVertices.lock();
-	target.draw(vertices, states);
-	for (auto& stone : stones)
-		target.draw(stone, states);
-	protectVertices.unlock();
+	target.draw(board, states);
+	states.texture = &stoneTexture;
+	protectStones.lock();
+	target.draw(stones, states);
+	protectStones.unlock();
+}
+
+bool UserView::hasChanged() const
+{
+	return dirty.exchange(false);
 }
 
 unsigned int UserView::index(unsigned int x, unsigned int y) const
@@ -117,13 +133,14 @@ void UserView::initHexagons()
 	cellTexture.loadFromFile("wood2.jpg");
 	cellTexture.setSmooth(true);
 	unsigned seed = chrono::system_clock::now().time_since_epoch().count();
-	minstd_rand0 generator(seed);
+	RandomEngine generator(seed);
 	
 	vertices.resize(size * size * 6 * 3);
 	vertices.setPrimitiveType(Triangles);
 	
 	float xBegin = (width - cellSize*(2*size + size - 1)) / 2.0 + cellSize;
 	float yBegin = height / 2.0;
+	origin = Vector2f(xBegin, yBegin);
 	complex<float> line(xBegin, yBegin);
 	for (unsigned int y = 0; y < size; ++y)
 	{
@@ -133,8 +150,8 @@ void UserView::initHexagons()
 			complex<float> center = column;
 			complex<float> needle = polar<float>(hexagonSize, 0);
 			
-			unsigned int xRand = generator()%(cellTexture.getSize().x - 2*unsigned(cellSize)) + cellSize;
-			unsigned int yRand = generator()%(cellTexture.getSize().y - 2*unsigned(cellSize)) + cellSize;
+			unsigned int xRand = generator.below(cellTexture.getSize().x - 2*unsigned(cellSize)) + cellSize;
+			unsigned int yRand = generator.below(cellTexture.getSize().y - 2*unsigned(cellSize)) + cellSize;
 			complex<float> centerTexture(xRand, yRand);
 			
 			Vertex * hexagon = &vertices[index(x, y)];
@@ -158,6 +175,18 @@ void UserView::initHexagons()
 	}
 }
 
+// The background and the hexagons never change: they are drawn once into a
+// texture, which each frame then copies.
+void UserView::initBoard()
+{
+	boardTexture.create(width, height);
+	boardTexture.clear();
+	boardTexture.draw(background);
+	boardTexture.draw(vertices, RenderStates(&cellTexture));
+	boardTexture.display();
+	board.setTexture(boardTexture.getTexture());
+}
+
 void UserView::initSide()
 {
 	float left = vertices[index(size/3, 0)].position.x;
@@ -165,13 +194,11 @@ void UserView::initSide()
 	float top = vertices[index(0, size - size/4 - 1)].position.y;
 	float bottom = vertices[index(size-1, size/4)].position.y;
 	
-	stones.push_back(createStone(left, top));
-	stones.push_back(createStone(right, bottom));
+	addStone(left, top, Color::White);
+	addStone(right, bottom, Color::White);
 	
-	stones.push_back(createStone(left, bottom));
-	stones.back().setColor(AIColor);
-	stones.push_back(createStone(right, top));
-	stones.back().setColor(AIColor);
+	addStone(left, bottom, AIColor);
+	addStone(right, top, AIColor);
 }
 
 bool UserView::isOpen() const
@@ -179,16 +206,23 @@ bool UserView::isOpen() const
 	return window->isOpen();
 }
 
+// Never blocks: the events already received are handed to the game, and false
+// means there was none for it.
 bool UserView::readUserInput()
 {
 	Event event;
-	while (window->waitEvent(event))
+	bool read = false;
+	while (window->pollEvent(event))
 	{
+		// What was on the screen may be lost.
+		if (event.type == Event::GainedFocus || event.type == Event::Resized)
+			dirty = true;
+			
 		if (event.type == Event::Closed
 		|| (event.type == Event::KeyPressed && event.key.code == Keyboard::Escape))
 		{
 			game->addEvent(GameEvent(GameEventType::Closed));
-			return true;
+			read = true;
 		}
 		
 		if (event.type == Event::MouseButtonPressed
@@ -198,12 +232,12 @@ bool UserView::readUserInput()
 			if (collision(event.mouseButton.x, event.mouseButton.y, position))
 			{
 				game->addEvent(GameEvent(GameEventType::Move, position, Player::Human));
-				return true;
+				read = true;
 			}
 		}
 	}
 	
-	return false;
+	return read;
 }
 
 void UserView::setColor(Vector2u position, Player player)
@@ -213,14 +247,7 @@ void UserView::setColor(Vector2u position, Player player)
 
 void UserView::setColor(unsigned int x, unsigned int y, Player player)
 {
-	protectVertices.lock();
-	const Vertex * hexagon = &vertices[index(x, y)];
-	Sprite stone = createStone(hexagon[0].position);
-	stone.setPosition(hexagon[0].position);
-	if (player == Player::AI)
-		stone.setColor(AIColor);
-	stones.push_back(stone);
-	protectVertices.unlock();
+	addStone(vertices[index(x, y)].position, player == Player::AI ? AIColor : Color::White);
 }
 
 UserView::~UserView()
@@ -1,19 +1,64 @@
 #include <fstream>
+#include <iostream>
+#include <string>
 
+#include "Agent.hpp"
+#include "Data.hpp"
 #include "Game.hpp"
 
 using namespace std;
 
 int main()
 {
-	unsigned int firstPlayer, size;
+	unsigned int firstPlayer = 0, size = 0;
+	unsigned int nbThreads = 1, mode = 0;
 	ifstream in("config.txt");
-	in >> firstPlayer >> size;
+	in >> firstPlayer >> size >> nbThreads >> mode;
+	if (size == 0 || size > Data::maxSize)
+	{
+		cerr << "config.txt: the board size must be between 1 and " << Data::maxSize
+		     << " (HEX_MAX_SIZE of the build)" << endl;
+		return 1;
+	}
+	
 	Player player = Player::Human;
 	if (firstPlayer == 1)
 		player = Player::AI;
+		
+	// Optional lines : number of search threads, then 0 (sequential), 1 (root) or 2 (tree) parallelism
+	SearchMode searchMode = SearchMode::Sequential;
+	if (mode == 1)
+		searchMode = SearchMode::RootParallel;
+	if (mode == 2)
+		searchMode = SearchMode::TreeParallel;
+		
+	// Then the search limits per move : seconds, playouts, nodes (0 for none) and early stop (0 or 1)
+	float time;
+	unsigned int playouts = 0, nodes = 0, earlyStop = 0;
+	if (!(in >> time))
+		time = 2.5f;
+	in >> playouts >> nodes >> earlyStop;
+	if (time <= 0.0f && playouts == 0 && nodes == 0)
+		time = 2.5f;
+	SearchLimits limits(Seconds(time), playouts, nodes, earlyStop == 1);
+	
+	// Then 1 to let the AI think during the human's turn
+	unsigned int ponder = 0;
+	in >> ponder;
+	
+	// Then the transposition table size in megabytes, 0 to disable it
+	unsigned int tableSize = 16;
+	in >> tableSize;
+	
+	// Then the RAVE equivalence parameter, 0 for plain UCT
+	unsigned int rave = 1000;
+	in >> rave;
+	
+	// And finally the opening book built by tools/Book, none by default
+	string book;
+	in >> book;
 
-	Game game(size, player);
+	Game game(size, player, searchMode, nbThreads, limits, ponder == 1, tableSize, rave, book);
 	game.launch();
 }
 
@@ -0,0 +1,368 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Agent.hpp"
+#include "Core.hpp"
+#include "Data.hpp"
+#include "PlayoutBatch.hpp"
+
+using namespace std;
+
+// Micro benchmarks of the board and of the search steps, and a macro benchmark
+// of whole searches, on every board size. Each benchmark doubles its number of
+// iterations until one run lasts --min-time seconds, then prints one JSON line:
+// {"name":"Data/copy/11","size":11,"iterations":...,"ns_per_op":...,"ops_per_second":...}
+// with the keys always in that order. Every input is drawn from fixed seeds, so
+// two builds run exactly the same work.
+
+static const unsigned int sizes[] = {7, 9, 11, 13, 19};
+static const unsigned int boardSeed = 7;
+static const unsigned int searchSeed = 11;
+// Playouts per leaf of PlayoutBatch/run.
+static const unsigned int batchSize = 8;
+
+typedef SteadyClock Timer;
+
+// Keeps the compiler from dropping a computation whose result is never used.
+template<typename T>
+static void keep(const T& value)
+{
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+class State
+{
+	public:
+
+		State(uint64_t _iterations) : iterations(_iterations), items(0), paused(Timer::duration::zero())
+		{}
+
+		// Time spent between pause() and resume() is not counted.
+		void pause()
+		{
+			pauseStart = Timer::now();
+		}
+
+		void resume()
+		{
+			paused += Timer::now() - pauseStart;
+		}
+
+		uint64_t iterations;
+		// Operations done, when one iteration does more than one.
+		uint64_t items;
+		Timer::duration paused;
+
+	private:
+
+		Timer::time_point pauseStart;
+};
+
+struct Benchmark
+{
+	string name;
+	unsigned int size;
+	function<void(State&)> body;
+};
+
+// A board filled with the given number of random moves, without a winner check.
+static Data randomBoard(unsigned int size, unsigned int nbMoves, RandomEngine& generator)
+{
+	Data data(size);
+	Player current = Player::AI;
+	for (unsigned int move = 0; move < nbMoves && data.winner() == Player::Empty; ++move)
+	{
+		vector<Cell> moves = data.moves();
+		data.makeMove(moves[generator.below(moves.size())], current);
+		current = nextPlayer(current);
+	}
+	return data;
+}
+
+// The cells of the board in a random order, as one game would fill them.
+static vector<Cell> randomOrder(unsigned int size, RandomEngine& generator)
+{
+	vector<Cell> cells = Data(size).moves();
+	generator.shuffle(cells.data(), cells.size());
+	return cells;
+}
+
+static void dataCopy(State& state, unsigned int size)
+{
+	RandomEngine generator(boardSeed);
+	Data data = randomBoard(size, size*size / 2, generator);
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		Data copy = data;
+		keep(copy);
+	}
+}
+
+// Fills the whole board, alternating players, one makeMove per cell.
+static void dataMakeMove(State& state, unsigned int size)
+{
+	RandomEngine generator(boardSeed);
+	vector<Cell> cells = randomOrder(size, generator);
+	Data empty(size);
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		Data data = empty;
+		Player current = Player::AI;
+		for (auto cell : cells)
+		{
+			data.makeMove(cell, current);
+			current = nextPlayer(current);
+		}
+		keep(data);
+	}
+	state.items = state.iterations * cells.size();
+}
+
+// The same moves, each game taken back to the empty board instead of copied.
+static void dataTakeBack(State& state, unsigned int size)
+{
+	RandomEngine generator(boardSeed);
+	vector<Cell> cells = randomOrder(size, generator);
+	Data data(size);
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		Player current = Player::AI;
+		for (auto cell : cells)
+		{
+			data.makeMove(cell, current);
+			current = nextPlayer(current);
+		}
+		keep(data);
+		data.takeBack(0);
+	}
+	state.items = state.iterations * cells.size();
+}
+
+static void dataMoves(State& state, unsigned int size)
+{
+	RandomEngine generator(boardSeed);
+	Data data = randomBoard(size, size*size / 2, generator);
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		vector<Cell> moves = data.moves();
+		keep(moves);
+	}
+}
+
+// The flood that decides every playout, on boards filled by playouts from the
+// empty board. Full boards always have a winner in Hex.
+static void dataFullBoardWinner(State& state, unsigned int size)
+{
+	state.pause();
+	RandomEngine generator(boardSeed);
+	Data empty(size);
+	Cell first(size / 2, size / 2);
+	empty.makeMove(first, Player::AI);
+	vector<Data> boards(1024, empty);
+	for (auto& board : boards)
+		board.fillAtRandom(first, Player::Human, generator);
+	state.resume();
+
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		Player winner = boards[iteration % boards.size()].fullBoardWinner();
+		keep(winner);
+	}
+}
+
+// One playout per iteration from the empty board. The pattern answers it plays
+// are the work of Data::respond(), which is private to the playout.
+static void dataMonteCarlo(State& state, unsigned int size)
+{
+	RandomEngine generator(boardSeed);
+	Data empty(size);
+	Cell first(size / 2, size / 2);
+	empty.makeMove(first, Player::AI);
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		Data board = empty;
+		Player winner = board.MonteCarlo(first, Player::Human, generator);
+		keep(winner);
+	}
+}
+
+// The playouts of one leaf in a batch, fills and flood of the boards side by side,
+// reported per playout to compare with Data/MonteCarlo.
+static void batchRun(State& state, unsigned int size, unsigned int nbPlayouts)
+{
+	RandomEngine generator(boardSeed);
+	Data empty(size);
+	Cell first(size / 2, size / 2);
+	empty.makeMove(first, Player::AI);
+	PlayoutBatch batch;
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		batch.run(empty, first, Player::Human, nbPlayouts, generator);
+		keep(batch);
+	}
+	state.items = state.iterations * batch.size();
+}
+
+// A tree grown by the given number of playouts from the empty board, on which
+// selection() and reachBack() are then timed without the playouts around them.
+class SearchFixture
+{
+	public:
+
+		SearchFixture(unsigned int size, unsigned int nbPlayouts) :
+		empty(size), worker(pool, nullptr, 1000.0f, searchSeed), root(pool.createNode())
+		{
+			root->player = Player::Human;
+			for (unsigned int playout = 0; playout < nbPlayouts; ++playout)
+			{
+				Data board = empty;
+				Tree * sheet = selection(root, board, Player::AI, worker);
+				Player winner = board.MonteCarlo(sheet->move(), nextPlayer(sheet->player), worker.generator);
+				reachBack(sheet, winner, worker, board);
+			}
+		}
+
+		Data empty;
+		TreePool pool;
+		Worker worker;
+		Tree * root;
+};
+
+static void agentSelection(State& state, unsigned int size)
+{
+	state.pause();
+	SearchFixture fixture(size, 4096);
+	state.resume();
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		Data board = fixture.empty;
+		Tree * sheet = selection(fixture.root, board, Player::AI, fixture.worker);
+
+		state.pause();
+		Player winner = board.MonteCarlo(sheet->move(), nextPlayer(sheet->player), fixture.worker.generator);
+		reachBack(sheet, winner, fixture.worker, board);
+		state.resume();
+	}
+}
+
+static void agentReachBack(State& state, unsigned int size)
+{
+	state.pause();
+	SearchFixture fixture(size, 4096);
+	state.resume();
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		state.pause();
+		Data board = fixture.empty;
+		Tree * sheet = selection(fixture.root, board, Player::AI, fixture.worker);
+		Player winner = board.MonteCarlo(sheet->move(), nextPlayer(sheet->player), fixture.worker.generator);
+		state.resume();
+
+		reachBack(sheet, winner, fixture.worker, board);
+	}
+}
+
+// One full search of the first move per iteration, reported per playout.
+static void agentUCT(State& state, unsigned int size, unsigned int nbPlayouts)
+{
+	for (uint64_t iteration = 0; iteration < state.iterations; ++iteration)
+	{
+		state.pause();
+		Data data(size);
+		unique_ptr<Agent> agent(new Agent(&data, size, Player::AI));
+		agent->setSeed(searchSeed);
+		agent->setLimits(SearchLimits(Seconds::zero(), nbPlayouts));
+		state.resume();
+		
+		Cell move = agent->UCT();
+		keep(move);
+		state.items += agent->playouts();
+		
+		state.pause();
+		agent.reset();
+		state.resume();
+	}
+}
+
+static void run(const Benchmark& benchmark, double minTime)
+{
+	uint64_t iterations = 1;
+	while (true)
+	{
+		State state(iterations);
+		Timer::time_point start = Timer::now();
+		benchmark.body(state);
+		double seconds = chrono::duration<double>(Timer::now() - start - state.paused).count();
+
+		if (seconds >= minTime || iterations >= (uint64_t(1) << 40))
+		{
+			uint64_t operations = (state.items != 0 ? state.items : iterations);
+			cout << "{\"name\":\"" << benchmark.name << "\""
+			     << ",\"size\":" << benchmark.size
+			     << ",\"iterations\":" << iterations
+			     << ",\"ns_per_op\":" << seconds * 1e9 / operations
+			     << ",\"ops_per_second\":" << operations / seconds << "}" << endl;
+			return ;
+		}
+		iterations *= 2;
+	}
+}
+
+static void usage(const char * name)
+{
+	cerr << "usage: " << name << " [--filter TEXT] [--min-time SECONDS] [--playouts N]\n";
+}
+
+int main(int argc, char ** argv)
+{
+	string filter;
+	double minTime = 0.5;
+	unsigned int nbPlayouts = 10000;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		string name = argv[arg];
+		if (arg + 1 >= argc)
+		{
+			usage(argv[0]);
+			return 1;
+		}
+		string value = argv[++arg];
+		if (name == "--filter")
+			filter = value;
+		else if (name == "--min-time")
+			minTime = strtod(value.c_str(), nullptr);
+		else if (name == "--playouts")
+			nbPlayouts = strtoul(value.c_str(), nullptr, 10);
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	vector<Benchmark> benchmarks;
+	for (auto size : sizes)
+	{
+		string suffix = "/" + to_string(size);
+		benchmarks.push_back({"Data/copy" + suffix, size, [=](State& state) { dataCopy(state, size); }});
+		benchmarks.push_back({"Data/makeMove" + suffix, size, [=](State& state) { dataMakeMove(state, size); }});
+		benchmarks.push_back({"Data/takeBack" + suffix, size, [=](State& state) { dataTakeBack(state, size); }});
+		benchmarks.push_back({"Data/moves" + suffix, size, [=](State& state) { dataMoves(state, size); }});
+		benchmarks.push_back({"Data/fullBoardWinner" + suffix, size, [=](State& state) { dataFullBoardWinner(state, size); }});
+		benchmarks.push_back({"Data/MonteCarlo" + suffix, size, [=](State& state) { dataMonteCarlo(state, size); }});
+		benchmarks.push_back({"PlayoutBatch/run" + suffix, size, [=](State& state) { batchRun(state, size, batchSize); }});
+		benchmarks.push_back({"Agent/selection" + suffix, size, [=](State& state) { agentSelection(state, size); }});
+		benchmarks.push_back({"Agent/reachBack" + suffix, size, [=](State& state) { agentReachBack(state, size); }});
+		benchmarks.push_back({"Agent/UCT" + suffix, size, [=](State& state) { agentUCT(state, size, nbPlayouts); }});
+	}
+
+	for (auto& benchmark : benchmarks)
+		if (benchmark.name.find(filter) != string::npos)
+			run(benchmark, minTime);
+}
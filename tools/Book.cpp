@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "Agent.hpp"
+#include "Core.hpp"
+#include "Data.hpp"
+#include "EngineOptions.hpp"
+#include "OpeningBook.hpp"
+
+using namespace std;
+
+// Builds the opening book offline: every position searched is independent, so the
+// worker threads each run an agent on the next position left. For each
+// size and each side, the book covers the positions reached when that side follows
+// the book and its opponent plays anything, up to --depth stones on the board.
+// One JSON summary line on stdout.
+
+struct Options : public EngineOptions
+{
+	Options() :
+	depth(1), workers(max(thread::hardware_concurrency(), 1u)), out("book.bin")
+	{}
+
+	vector<unsigned int> sizes;
+	unsigned int depth;
+	unsigned int workers;
+	string out;
+};
+
+// The moves alternate from the first player, so that toMove plays next.
+struct Position
+{
+	unsigned int size;
+	Player toMove;
+	vector<Cell> moves;
+};
+
+static void usage(const char * name)
+{
+	cerr << "usage: " << name << " --sizes N[,N...] [--depth N] [--workers N] [--out FILE] "
+	     << EngineOptions::usage() << "\n";
+}
+
+static bool parse(int argc, char ** argv, Options& options)
+{
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (arg + 1 >= argc)
+			return false;
+
+		string name = argv[arg];
+		string value = argv[++arg];
+		if (name == "--sizes")
+		{
+			const char * list = value.c_str();
+			char * end = nullptr;
+			for (options.sizes.clear(); *list != '\0'; list = (*end == ',' ? end + 1 : end))
+			{
+				options.sizes.push_back(strtoul(list, &end, 10));
+				if (end == list || options.sizes.back() == 0 || options.sizes.back() > Data::maxSize)
+					return false;
+			}
+		}
+		else if (name == "--depth")
+			options.depth = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--workers")
+			options.workers = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--out")
+			options.out = value;
+		else if (!options.parse(name, value))
+			return false;
+	}
+
+	// The book is built from scratch, without telemetry.
+	options.defaultTime(10.0f);
+	return !options.sizes.empty() && options.workers > 0 && options.threads > 0
+	       && options.telemetry.empty() && options.book.empty();
+}
+
+static Data replay(const Position& position)
+{
+	Data data(position.size);
+	Player current = (position.moves.size() % 2 == 0) ? position.toMove : nextPlayer(position.toMove);
+	for (auto move : position.moves)
+	{
+		data.makeMove(move, current);
+		current = nextPlayer(current);
+	}
+	return data;
+}
+
+// Adds the position unless a transposition of it is already in the book.
+static void add(const Position& position, set<tuple<uint64_t, unsigned int, Player>>& known, vector<Position>& positions)
+{
+	Data data = replay(position);
+	if (data.winner() == Player::Empty && known.insert(make_tuple(data.hash(), position.size, position.toMove)).second)
+		positions.push_back(position);
+}
+
+static void searchAll(const vector<Position>& positions, vector<OpeningBook::Entry>& found, const Options& options)
+{
+	SearchLimits limits = options.limits();
+	atomic<unsigned int> next(0);
+	vector<thread> workers;
+	for (unsigned int worker = 0; worker < options.workers; ++worker)
+	{
+		workers.emplace_back([&]()
+		{
+			for (unsigned int index = next++; index < positions.size(); index = next++)
+			{
+				const Position& position = positions[index];
+				Data data = replay(position);
+				Agent agent(&data, position.size, position.toMove, options.mode, options.threads);
+				agent.setLimits(limits);
+				agent.setSeed(options.seed + index);
+				options.configure(agent, nullptr, nullptr);
+				Cell move = agent.UCT();
+
+				OpeningBook::Entry& entry = found[index];
+				entry.hash = data.hash();
+				entry.size = position.size;
+				entry.player = uint8_t(position.toMove);
+				entry.x = move.x;
+				entry.y = move.y;
+				entry.playouts = agent.playouts();
+			}
+		});
+	}
+	for (auto& worker : workers)
+		worker.join();
+}
+
+int main(int argc, char ** argv)
+{
+	Options options;
+	if (!parse(argc, argv, options))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	// The positions with n and n + 1 stones are searched together, those with n + 2
+	// and n + 3 follow from their book moves.
+	set<tuple<uint64_t, unsigned int, Player>> known;
+	vector<Position> positions;
+	for (auto size : options.sizes)
+	{
+		for (auto side : {Player::AI, Player::Human})
+		{
+			Position empty = {size, side, vector<Cell>()};
+			add(empty, known, positions);
+			if (options.depth == 0)
+				continue;
+			for (auto reply : Data(size).moves())
+			{
+				Position opening = {size, side, vector<Cell>(1, reply)};
+				add(opening, known, positions);
+			}
+		}
+	}
+
+	vector<OpeningBook::Entry> book;
+	unsigned long long totalPlayouts = 0;
+	SteadyClock::time_point start = SteadyClock::now();
+	for (unsigned int stones = 0; !positions.empty(); stones += 2)
+	{
+		vector<OpeningBook::Entry> found(positions.size());
+		searchAll(positions, found, options);
+
+		vector<Position> deeper;
+		for (unsigned int index = 0; index < positions.size(); ++index)
+		{
+			book.push_back(found[index]);
+			totalPlayouts += found[index].playouts;
+			if (positions[index].moves.size() + 2 > options.depth)
+				continue;
+
+			Position followed = positions[index];
+			followed.moves.push_back(Cell(found[index].x, found[index].y));
+			for (auto reply : replay(followed).moves())
+			{
+				Position next = followed;
+				next.moves.push_back(reply);
+				add(next, known, deeper);
+			}
+		}
+		positions.swap(deeper);
+		cerr << "stones " << stones << "-" << stones + 1 << ": " << book.size() << " positions in the book" << endl;
+	}
+
+	if (!OpeningBook::write(options.out, book))
+	{
+		cerr << "cannot write " << options.out << endl;
+		return 1;
+	}
+
+	double seconds = Seconds(SteadyClock::now() - start).count();
+	cout << "{\"sizes\":[";
+	for (unsigned int size = 0; size < options.sizes.size(); ++size)
+		cout << (size == 0 ? "" : ",") << options.sizes[size];
+	cout << "],\"depth\":" << options.depth
+	     << ",\"time\":" << options.time
+	     << ",\"playouts_per_move\":" << options.playouts
+	     << ",\"workers\":" << options.workers
+	     << ",\"threads\":" << options.threads
+	     << ",\"seed\":" << options.seed
+	     << ",\"hash\":" << options.hash
+	     << ",\"rave\":" << options.rave
+	     << ",\"batch\":" << options.batch
+	     << ",\"positions\":" << book.size()
+	     << ",\"seconds\":" << seconds
+	     << ",\"playouts\":" << totalPlayouts
+	     << ",\"out\":\"" << options.out << "\"}" << endl;
+}
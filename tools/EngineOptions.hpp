@@ -0,0 +1,105 @@
+#ifndef ENGINE_OPTIONS_HPP
+#define ENGINE_OPTIONS_HPP
+
+#include <cstdlib>
+#include <ostream>
+#include <string>
+
+#include "Agent.hpp"
+#include "Core.hpp"
+#include "OpeningBook.hpp"
+
+// The search options shared by the tools, read from the command line and handed
+// to the agents in one place. Each tool parses its own flags and passes the
+// others here, so that a new engine option is added once for all of them.
+struct EngineOptions
+{
+	EngineOptions() :
+	time(0.0f), playouts(0), nodes(0), earlyStop(false), threads(1), mode(SearchMode::Sequential),
+	seeded(false), seed(0), hash(16), rave(1000), batch(1)
+	{}
+
+	// False when the flag is not an engine option.
+	bool parse(const std::string& name, const std::string& value)
+	{
+		if (name == "--time")
+			time = strtof(value.c_str(), nullptr);
+		else if (name == "--playouts")
+			playouts = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--nodes")
+			nodes = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--early-stop")
+			earlyStop = (value == "1");
+		else if (name == "--threads")
+			threads = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--seed")
+		{
+			seeded = true;
+			seed = strtoul(value.c_str(), nullptr, 10);
+		}
+		else if (name == "--hash")
+			hash = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--rave")
+			rave = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--batch")
+			batch = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--telemetry")
+			telemetry = value;
+		else if (name == "--book")
+			book = value;
+		else if (name == "--mode" && value == "sequential")
+			mode = SearchMode::Sequential;
+		else if (name == "--mode" && value == "root")
+			mode = SearchMode::RootParallel;
+		else if (name == "--mode" && value == "tree")
+			mode = SearchMode::TreeParallel;
+		else
+			return false;
+		return true;
+	}
+
+	// The time given to a move when the command line set no limit at all.
+	void defaultTime(float seconds)
+	{
+		if (time <= 0.0f && playouts == 0 && nodes == 0)
+			time = seconds;
+	}
+
+	SearchLimits limits() const
+	{
+		return SearchLimits(Seconds(time), playouts, nodes, earlyStop);
+	}
+
+	// Everything but the limits and the seed, which each tool sets its own way.
+	void configure(Agent& agent, std::ostream * telemetryStream, const OpeningBook * openingBook) const
+	{
+		agent.setTableSize(hash);
+		agent.setRave(rave);
+		agent.setBatch(batch);
+		agent.setTelemetry(telemetryStream);
+		agent.setBook(openingBook);
+	}
+
+	static const char * usage()
+	{
+		return "[--time SECONDS] [--playouts N] [--nodes N] [--early-stop 0|1] [--threads N]"
+		       " [--mode sequential|root|tree] [--seed N] [--hash MEGABYTES] [--rave K] [--batch N]"
+		       " [--telemetry FILE] [--book FILE]";
+	}
+
+	float time;
+	unsigned int playouts;
+	unsigned int nodes;
+	bool earlyStop;
+	unsigned int threads;
+	SearchMode mode;
+	bool seeded;
+	unsigned int seed;
+	unsigned int hash;
+	unsigned int rave;
+	unsigned int batch;
+	std::string telemetry;
+	std::string book;
+};
+
+#endif
@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Agent.hpp"
+#include "Core.hpp"
+#include "Data.hpp"
+#include "EngineOptions.hpp"
+#include "OpeningBook.hpp"
+
+using namespace std;
+
+// The engine as a text protocol server, for match runners and GUIs: the Go Text
+// Protocol as adapted to Hex (HTP), one command per line on stdin and one answer
+// per command on stdout, in a single long-lived process. Black connects top to
+// bottom like Player::AI, white left to right like Player::Human. A cell is a
+// column letter and a row number, a1 being the top left corner.
+
+static const unsigned int defaultSize = 11;
+// Share of the clock a move may use, the rest covers the protocol and the host.
+static const double safety = 0.9;
+
+struct Options : public EngineOptions
+{
+	Options() : ponder(false)
+	{}
+
+	bool ponder;
+};
+
+// Time left to one player, counted down by its own moves. While stones is not
+// zero, the player is in byo-yomi and must play that many moves in the time left.
+struct Clock
+{
+	Clock() : left(0.0), stones(0)
+	{}
+
+	double left;
+	unsigned int stones;
+};
+
+class Engine
+{
+	public:
+
+		Engine(const Options&);
+		Engine(const Engine&) = delete;
+		Engine& operator=(const Engine&) = delete;
+
+		// Runs one command and writes its answer, returns false if the answer is an error.
+		bool execute(const string&, istream&, string&);
+		bool finished() const;
+
+	private:
+
+		bool boardSize(istream&, string&);
+		bool play(istream&, string&);
+		bool genMove(istream&, string&);
+		bool undo(string&);
+		bool timeSettings(istream&, string&);
+		bool timeLeft(istream&, string&);
+		string showBoard() const;
+
+		void reset(unsigned int);
+		void playMove(Cell, Player);
+		void dropTrees();
+		Agent& agent(Player);
+		SearchLimits limits(Player) const;
+		void spend(Player, double);
+
+		Options options;
+		unsigned int size;
+		Data data;
+		Player toMove;
+		vector<pair<Cell, Player>> history;
+		unique_ptr<Agent> agents[2];
+		ofstream telemetry;
+		OpeningBook book;
+		bool timed;
+		double byoYomiTime;
+		unsigned int byoYomiStones;
+		Clock clocks[2];
+		bool quit;
+};
+
+static const char * const commands[] =
+{
+	"boardsize", "clear_board", "genmove", "known_command", "list_commands", "name", "play",
+	"protocol_version", "quit", "showboard", "time_left", "time_settings", "undo", "version"
+};
+
+static unsigned int side(Player player)
+{
+	return player == Player::AI ? 0 : 1;
+}
+
+static bool parseColor(const string& word, Player& player)
+{
+	string color = word;
+	transform(color.begin(), color.end(), color.begin(), ::tolower);
+	if (color == "b" || color == "black")
+		player = Player::AI;
+	else if (color == "w" || color == "white")
+		player = Player::Human;
+	else
+		return false;
+	return true;
+}
+
+static bool parseCell(const string& word, unsigned int size, Cell& cell)
+{
+	if (word.size() < 2 || !isalpha(word[0]))
+		return false;
+	unsigned int x = tolower(word[0]) - 'a';
+	unsigned int y = 0;
+	for (unsigned int digit = 1; digit < word.size(); ++digit)
+	{
+		if (!isdigit(word[digit]) || y > size)
+			return false;
+		y = 10*y + (word[digit] - '0');
+	}
+	if (x >= size || y == 0 || y > size)
+		return false;
+	cell = Cell(x, y - 1);
+	return true;
+}
+
+static string cellName(Cell cell)
+{
+	return string(1, char('a' + cell.x)) + to_string(cell.y + 1);
+}
+
+Engine::Engine(const Options& _options) :
+options(_options), size(defaultSize), data(defaultSize), toMove(Player::AI),
+timed(false), byoYomiTime(0.0), byoYomiStones(0), quit(false)
+{
+	if (!options.telemetry.empty())
+		telemetry.open(options.telemetry.c_str());
+	if (!options.book.empty() && !book.open(options.book))
+		cerr << "cannot open the book " << options.book << endl;
+}
+
+bool Engine::finished() const
+{
+	return quit;
+}
+
+bool Engine::execute(const string& command, istream& arguments, string& answer)
+{
+	if (command == "protocol_version")
+		answer = "2";
+	else if (command == "name")
+		answer = "Hex-Game";
+	else if (command == "version")
+		answer = "1.0";
+	else if (command == "known_command")
+	{
+		string name;
+		arguments >> name;
+		answer = (find(begin(commands), end(commands), name) != end(commands) ? "true" : "false");
+	}
+	else if (command == "list_commands")
+	{
+		for (auto name : commands)
+			answer += (answer.empty() ? "" : "\n") + string(name);
+	}
+	else if (command == "quit")
+		quit = true;
+	else if (command == "boardsize")
+		return boardSize(arguments, answer);
+	else if (command == "clear_board")
+		reset(size);
+	else if (command == "play")
+		return play(arguments, answer);
+	else if (command == "genmove")
+		return genMove(arguments, answer);
+	else if (command == "undo")
+		return undo(answer);
+	else if (command == "time_settings")
+		return timeSettings(arguments, answer);
+	else if (command == "time_left")
+		return timeLeft(arguments, answer);
+	else if (command == "showboard")
+		answer = showBoard();
+	else
+	{
+		answer = "unknown command";
+		return false;
+	}
+	return true;
+}
+
+// Hex front ends send both dimensions, Go ones a single one.
+bool Engine::boardSize(istream& arguments, string& answer)
+{
+	unsigned int width = 0, height = 0;
+	arguments >> width;
+	if (!(arguments >> height))
+		height = width;
+	if (width == 0 || width > Data::maxSize || height != width)
+	{
+		answer = "unacceptable size";
+		return false;
+	}
+	reset(width);
+	return true;
+}
+
+bool Engine::play(istream& arguments, string& answer)
+{
+	string color, vertex;
+	Player player;
+	Cell cell;
+	arguments >> color >> vertex;
+	if (!parseColor(color, player) || !parseCell(vertex, size, cell))
+	{
+		answer = "syntax error";
+		return false;
+	}
+	if (!data.isLegal(cell))
+	{
+		answer = "illegal move";
+		return false;
+	}
+	playMove(cell, player);
+	return true;
+}
+
+bool Engine::genMove(istream& arguments, string& answer)
+{
+	string color;
+	Player player;
+	arguments >> color;
+	if (!parseColor(color, player))
+	{
+		answer = "syntax error";
+		return false;
+	}
+	if (data.winner() != Player::Empty)
+	{
+		answer = "resign";
+		return true;
+	}
+
+	// From here on the game goes on with this player, so that playMove() keeps the
+	// searcher.
+	if (player != toMove)
+	{
+		dropTrees();
+		toMove = player;
+	}
+	for (auto& other : agents)
+		if (other != nullptr)
+			other->stopPondering();
+
+	Agent& searcher = agent(player);
+	searcher.setLimits(limits(player));
+	SteadyClock::time_point start = SteadyClock::now();
+	Cell move = searcher.UCT();
+	spend(player, Seconds(SteadyClock::now() - start).count());
+
+	playMove(move, player);
+	searcher.ponder();
+	answer = cellName(move);
+	return true;
+}
+
+// The trees only go forward: the move is taken back and the position searched
+// afresh.
+bool Engine::undo(string& answer)
+{
+	if (history.empty())
+	{
+		answer = "cannot undo";
+		return false;
+	}
+	dropTrees();
+	data.takeBack(data.nbPlayed() - 1);
+	toMove = history.back().second;
+	history.pop_back();
+	return true;
+}
+
+// Zero main time and zero byo-yomi time mean no time limit.
+bool Engine::timeSettings(istream& arguments, string& answer)
+{
+	double mainTime = 0.0;
+	if (!(arguments >> mainTime >> byoYomiTime >> byoYomiStones))
+	{
+		answer = "syntax error";
+		return false;
+	}
+	timed = (mainTime > 0.0 || byoYomiTime > 0.0);
+	for (auto& clock : clocks)
+	{
+		clock.left = mainTime;
+		clock.stones = 0;
+		if (mainTime <= 0.0 && byoYomiStones > 0)
+		{
+			clock.left = byoYomiTime;
+			clock.stones = byoYomiStones;
+		}
+	}
+	return true;
+}
+
+// The controller's clock prevails over ours.
+bool Engine::timeLeft(istream& arguments, string& answer)
+{
+	string color;
+	Player player;
+	Clock clock;
+	if (!(arguments >> color >> clock.left >> clock.stones) || !parseColor(color, player))
+	{
+		answer = "syntax error";
+		return false;
+	}
+	clocks[side(player)] = clock;
+	return true;
+}
+
+string Engine::showBoard() const
+{
+	ostringstream out;
+	out << "\n   ";
+	for (unsigned int x = 0; x < size; ++x)
+		out << ' ' << char('a' + x);
+	for (unsigned int y = 0; y < size; ++y)
+	{
+		out << '\n' << string(y, ' ') << setw(3) << y + 1;
+		for (unsigned int x = 0; x < size; ++x)
+		{
+			Player stone = data(x, y);
+			out << ' ' << (stone == Player::AI ? 'X' : stone == Player::Human ? 'O' : '.');
+		}
+	}
+	return out.str();
+}
+
+void Engine::reset(unsigned int _size)
+{
+	for (auto& agent : agents)
+		agent.reset();
+	size = _size;
+	data = Data(size);
+	toMove = Player::AI;
+	history.clear();
+}
+
+// The agents follow the game in their trees as long as the colors alternate.
+void Engine::playMove(Cell cell, Player player)
+{
+	if (player != toMove)
+		dropTrees();
+	for (auto& agent : agents)
+		if (agent != nullptr)
+			agent->stopPondering();
+
+	data.makeMove(cell, player);
+	for (auto& agent : agents)
+		if (agent != nullptr)
+			agent->pruning(cell);
+	history.push_back(make_pair(cell, player));
+	toMove = nextPlayer(player);
+}
+
+void Engine::dropTrees()
+{
+	for (auto& agent : agents)
+		agent.reset();
+}
+
+// Created on the first genmove of its color, the agent then keeps its tree
+// between moves.
+Agent& Engine::agent(Player player)
+{
+	unique_ptr<Agent>& agent = agents[side(player)];
+	if (agent == nullptr)
+	{
+		agent.reset(new Agent(&data, size, player, options.mode, options.threads));
+		agent->setPondering(options.ponder);
+		if (options.seeded)
+			agent->setSeed(options.seed + side(player));
+		options.configure(*agent, telemetry.is_open() ? &telemetry : nullptr, &book);
+	}
+	return *agent;
+}
+
+// Without a clock, the limits of the command line. With one, the time left is
+// shared between the moves the player may still have to play, and in byo-yomi
+// between the stones of the period.
+SearchLimits Engine::limits(Player player) const
+{
+	if (!timed)
+		return options.limits();
+
+	const Clock& clock = clocks[side(player)];
+	double budget;
+	if (clock.stones > 0)
+		budget = clock.left / clock.stones;
+	else
+	{
+		budget = max(clock.left, 0.0) / max(data.nbMoves() / 2, 1u);
+		if (byoYomiStones > 0)
+			budget += byoYomiTime / byoYomiStones;
+	}
+	budget = max(safety * budget, 0.01);
+	return SearchLimits(Seconds(budget), options.playouts, options.nodes, options.earlyStop);
+}
+
+void Engine::spend(Player player, double seconds)
+{
+	Clock& clock = clocks[side(player)];
+	clock.left -= seconds;
+	bool periodDone = (clock.stones > 0 && --clock.stones == 0);
+	if (byoYomiStones > 0 && clock.stones == 0 && (periodDone || clock.left <= 0.0))
+	{
+		clock.left = byoYomiTime;
+		clock.stones = byoYomiStones;
+	}
+}
+
+static void usage(const char * name)
+{
+	cerr << "usage: " << name << " " << EngineOptions::usage() << " [--ponder 0|1]\n";
+}
+
+static bool parse(int argc, char ** argv, Options& options)
+{
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (arg + 1 >= argc)
+			return false;
+
+		string name = argv[arg];
+		string value = argv[++arg];
+		if (name == "--ponder")
+			options.ponder = (value == "1");
+		else if (!options.parse(name, value))
+			return false;
+	}
+
+	options.defaultTime(2.5f);
+	return true;
+}
+
+// Control characters go, tabs become spaces and comments are cut.
+static string clean(const string& line)
+{
+	string result;
+	for (char c : line)
+	{
+		if (c == '#')
+			break;
+		if (c == '\t')
+			result += ' ';
+		else if (!iscntrl(static_cast<unsigned char>(c)))
+			result += c;
+	}
+	return result;
+}
+
+int main(int argc, char ** argv)
+{
+	Options options;
+	if (!parse(argc, argv, options))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	Engine engine(options);
+	string line;
+	while (!engine.finished() && getline(cin, line))
+	{
+		istringstream arguments(clean(line));
+		string id, command;
+		if (!(arguments >> command))
+			continue;
+		if (all_of(command.begin(), command.end(), ::isdigit))
+		{
+			id = command;
+			command.clear();
+			arguments >> command;
+		}
+
+		string answer;
+		bool success = engine.execute(command, arguments, answer);
+		cout << (success ? '=' : '?') << id << ' ' << answer << "\n\n" << flush;
+	}
+}
@@ -0,0 +1,170 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Agent.hpp"
+#include "Core.hpp"
+#include "Data.hpp"
+#include "EngineOptions.hpp"
+#include "OpeningBook.hpp"
+
+using namespace std;
+
+// Headless AI-vs-AI (or AI-vs-random) games, one JSON object per game on stdout
+// followed by a summary line. The tested agent connects top to bottom (Player::AI),
+// its opponent left to right (Player::Human); the first mover alternates.
+
+struct Options : public EngineOptions
+{
+	Options() : 
+	size(11), games(10), randomOpponent(false)
+	{}
+
+	unsigned int size;
+	unsigned int games;
+	bool randomOpponent;
+};
+
+static void usage(const char * name)
+{
+	cerr << "usage: " << name << " [--size N] [--games N] [--opponent agent|random] "
+	     << EngineOptions::usage() << "\n";
+}
+
+static bool parse(int argc, char ** argv, Options& options)
+{
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (arg + 1 >= argc)
+			return false;
+			
+		string name = argv[arg];
+		string value = argv[++arg];
+		if (name == "--size")
+			options.size = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--games")
+			options.games = strtoul(value.c_str(), nullptr, 10);
+		else if (name == "--opponent" && (value == "agent" || value == "random"))
+			options.randomOpponent = (value == "random");
+		else if (!options.parse(name, value))
+			return false;
+	}
+	
+	options.defaultTime(2.5f);
+	return options.size > 0 && options.size <= Data::maxSize && options.games > 0;
+}
+
+int main(int argc, char ** argv)
+{
+	Options options;
+	if (!parse(argc, argv, options))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+	
+	SearchLimits limits = options.limits();
+	RandomEngine seeds(options.seed);
+	unsigned long long totalPlayouts = 0;
+	unsigned int agentWins = 0;
+	unsigned int firstPlayerWins = 0;
+	
+	ofstream telemetry;
+	if (!options.telemetry.empty())
+		telemetry.open(options.telemetry.c_str());
+	
+	// Only the tested agent plays from the book.
+	OpeningBook book;
+	if (!options.book.empty() && !book.open(options.book))
+	{
+		cerr << "cannot open the book " << options.book << endl;
+		return 1;
+	}
+	
+	SteadyClock::time_point total = SteadyClock::now();
+	for (unsigned int game = 0; game < options.games; ++game)
+	{
+		Data data(options.size);
+		Agent agent(&data, options.size, Player::AI, options.mode, options.threads);
+		agent.setLimits(limits);
+		agent.setSeed(seeds());
+		options.configure(agent, telemetry.is_open() ? &telemetry : nullptr, &book);
+		
+		unique_ptr<Agent> opponent;
+		if (!options.randomOpponent)
+		{
+			opponent.reset(new Agent(&data, options.size, Player::Human, options.mode, options.threads));
+			opponent->setLimits(limits);
+			opponent->setSeed(seeds());
+			options.configure(*opponent, telemetry.is_open() ? &telemetry : nullptr, nullptr);
+		}
+		RandomEngine randomPlayer(seeds());
+		
+		Player first = (game % 2 == 0) ? Player::AI : Player::Human;
+		Player current = first;
+		unsigned int nbMoves = 0;
+		unsigned long long gamePlayouts = 0;
+		SteadyClock::time_point start = SteadyClock::now();
+		while (data.winner() == Player::Empty)
+		{
+			Cell move;
+			if (current == Player::AI)
+			{
+				move = agent.UCT();
+				gamePlayouts += agent.playouts();
+			}
+			else if (opponent != nullptr)
+			{
+				move = opponent->UCT();
+				gamePlayouts += opponent->playouts();
+			}
+			else
+			{
+				vector<Cell> moves = data.moves();
+				move = moves[randomPlayer.below(moves.size())];
+			}
+			
+			data.makeMove(move, current);
+			agent.pruning(move);
+			if (opponent != nullptr)
+				opponent->pruning(move);
+			current = nextPlayer(current);
+			++nbMoves;
+		}
+		
+		Player winner = data.winner();
+		agentWins += (winner == Player::AI);
+		firstPlayerWins += (winner == first);
+		totalPlayouts += gamePlayouts;
+		
+		cout << "{\"game\":" << game
+		     << ",\"first\":\"" << (first == Player::AI ? "agent" : "opponent")
+		     << "\",\"winner\":\"" << (winner == Player::AI ? "agent" : "opponent")
+		     << "\",\"moves\":" << nbMoves
+		     << ",\"seconds\":" << Seconds(SteadyClock::now() - start).count()
+		     << ",\"playouts\":" << gamePlayouts << "}" << endl;
+	}
+	
+	double seconds = Seconds(SteadyClock::now() - total).count();
+	cout << "{\"size\":" << options.size
+	     << ",\"games\":" << options.games
+	     << ",\"opponent\":\"" << (options.randomOpponent ? "random" : "agent")
+	     << "\",\"time\":" << options.time
+	     << ",\"playouts_per_move\":" << options.playouts
+	     << ",\"nodes_per_move\":" << options.nodes
+	     << ",\"early_stop\":" << options.earlyStop
+	     << ",\"threads\":" << options.threads
+	     << ",\"seed\":" << options.seed
+	     << ",\"hash\":" << options.hash
+	     << ",\"rave\":" << options.rave
+	     << ",\"batch\":" << options.batch
+	     << ",\"seconds\":" << seconds
+	     << ",\"games_per_second\":" << options.games / seconds
+	     << ",\"playouts\":" << totalPlayouts
+	     << ",\"playouts_per_second\":" << totalPlayouts / seconds
+	     << ",\"agent_win_rate\":" << double(agentWins) / options.games
+	     << ",\"first_player_win_rate\":" << double(firstPlayerWins) / options.games << "}" << endl;
+}